@@ -16,6 +16,8 @@ namespace zepo {
         std::string registry{};
         std::optional<std::string> authUsername{};
         std::optional<std::string> authPassword{};
+        // "none", "package" (default) or "install", see storage/Durability.hpp
+        std::optional<std::string> durability{};
     };
 }
 
@@ -23,6 +25,7 @@ ZEPO_REFLECT_INFO_BEGIN_(zepo::Configuration)
     ZEPO_REFLECT_FIELD_(registry);
     ZEPO_REFLECT_FIELD_(authUsername);
     ZEPO_REFLECT_FIELD_(authPassword);
+    ZEPO_REFLECT_FIELD_(durability);
 ZEPO_REFLECT_INFO_END_()
 
 ZEPO_REFLECT_PARSABLE_(zepo::Configuration);
@@ -7,6 +7,8 @@
 namespace zepo {
     Configuration globalConfiguration{};
 
+    storage::DurabilityMode globalDurabilityMode{storage::DurabilityMode::Package};
+
     JSRuntime* globalJsRuntime{nullptr};
 
     ApplicationPaths applicationPaths{};
@@ -10,6 +10,7 @@
 #include <filesystem>
 
 #include "zepo/Configuration.hpp"
+#include "zepo/storage/Durability.hpp"
 
 namespace zepo {
     struct ApplicationPaths {
@@ -19,6 +20,8 @@ namespace zepo {
     };
 
     extern Configuration globalConfiguration;
+    // parsed from `globalConfiguration.durability` once the configuration is loaded
+    extern storage::DurabilityMode globalDurabilityMode;
     extern JSRuntime* globalJsRuntime;
     extern ApplicationPaths applicationPaths;
 }
@@ -0,0 +1,50 @@
+//
+// Created by qingy on 2024/8/3.
+//
+
+#pragma once
+#ifndef ZEPO_INSTALLATIONMANIFEST_HPP
+#define ZEPO_INSTALLATIONMANIFEST_HPP
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "serialize/Reflect.hpp"
+#include "serialize/Serializer.hpp"
+
+namespace zepo {
+    struct InstalledFile {
+        std::string path;
+        uint64_t size;
+    };
+
+    // written as "zepo-installation.lock" once a package has been extracted into the store
+    struct InstallationManifest {
+        std::string name;
+        std::string version;
+        std::string tarball;
+        std::string integrity;
+        std::string shasum;
+        std::vector<InstalledFile> files;
+    };
+}
+
+ZEPO_REFLECT_INFO_BEGIN_(zepo::InstalledFile)
+    ZEPO_REFLECT_FIELD_(path);
+    ZEPO_REFLECT_FIELD_(size);
+ZEPO_REFLECT_INFO_END_()
+
+ZEPO_REFLECT_PARSABLE_(zepo::InstalledFile);
+
+ZEPO_REFLECT_INFO_BEGIN_(zepo::InstallationManifest)
+    ZEPO_REFLECT_FIELD_(name);
+    ZEPO_REFLECT_FIELD_(version);
+    ZEPO_REFLECT_FIELD_(tarball);
+    ZEPO_REFLECT_FIELD_(integrity);
+    ZEPO_REFLECT_FIELD_(shasum);
+    ZEPO_REFLECT_FIELD_(files);
+ZEPO_REFLECT_INFO_END_()
+
+ZEPO_REFLECT_PARSABLE_(zepo::InstallationManifest);
+
+#endif //ZEPO_INSTALLATIONMANIFEST_HPP
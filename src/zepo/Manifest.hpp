@@ -5,9 +5,9 @@
 #pragma once
 #ifndef ZEPO_MANIFEST_HPP
 #define ZEPO_MANIFEST_HPP
-#include <map>
 #include <string>
 
+#include "container/FlatMap.hpp"
 #include "serialize/Json.hpp"
 #include "serialize/Reflect.hpp"
 #include "serialize/Serializer.hpp"
@@ -17,8 +17,8 @@ namespace zepo {
 
     struct Package {
         std::string name;
-        std::map<std::string, std::string> dependencies;
-        std::map<std::string, std::string> devDependencies;
+        FlatMap<std::string, std::string> dependencies;
+        FlatMap<std::string, std::string> devDependencies;
         std::string version;
     };
 }
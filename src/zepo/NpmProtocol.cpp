@@ -5,14 +5,21 @@
 #include "NpmProtocol.hpp"
 
 #include <archive.h>
+#include <algorithm>
 #include <archive_entry.h>
+#include <chrono>
+#include <exception>
 #include <fstream>
+#include <mutex>
 #include <string>
+#include <utility>
 
+#include "async/Executor.hpp"
+#include "async/TaskCompletionSource.hpp"
+#include "async/WorkStealingPool.hpp"
 #include "diagnostics/PerfDiagnostics.hpp"
 #include "network/CurlAsyncIO.hpp"
-#include "serialize/Json.hpp"
-#include "serialize/Serializer.hpp"
+#include "serialize/JsonStream.hpp"
 
 namespace zepo {
     inline void createDirectoriesIfNeed(const std::filesystem::path& path) {
@@ -24,7 +31,8 @@ namespace zepo {
     static size_t curlStreamWriter(const void* data, const size_t size, const size_t count, void* typelessStreamPtr) {
         auto* streamPtr = static_cast<std::iostream*>(typelessStreamPtr);
         streamPtr->write(static_cast<const char*>(data), size * count);
-        return size * count;
+        // 0 makes curl fail the transfer with CURLE_WRITE_ERROR, e.g. when the disk is full
+        return streamPtr->good() ? size * count : 0;
     }
 
     inline void configureNpmAuth(CURL* instance, const std::optional<std::string_view>& username,
@@ -43,29 +51,341 @@ namespace zepo {
         }
     }
 
+    namespace {
+        // picks `name` and `versions.*.{version,dependencies,dist}` out of the event stream and skips the rest,
+        // readmes and descriptions are never even decoded
+        class PackumentExtractor final : public JsonStreamHandler {
+            enum class Scope : uint8_t {
+                Other,
+                Root,
+                Versions,
+                Version,
+                Dependencies,
+                Dist,
+            };
+
+            enum class Field : uint8_t {
+                None,
+                Name,
+                Version,
+                Dependency,
+                Shasum,
+                Tarball,
+                Integrity,
+            };
+
+            std::vector<Scope> scopes_{};
+            // the scope an object opening right now gets, and where a string arriving right now goes
+            Scope nextScope_{Scope::Other};
+            Field field_{Field::None};
+
+            std::string_view dependencyName_{};
+            std::vector<std::pair<std::string_view, std::string_view>> dependencies_{};
+
+        public:
+            StringPool strings{};
+            std::string name{};
+            std::vector<NpmVersionEntry> versions{};
+
+            void onObjectBegin() override {
+                scopes_.push_back(scopes_.empty() ? Scope::Root : nextScope_);
+                nextScope_ = Scope::Other;
+                field_ = Field::None;
+            }
+
+            void onObjectEnd() override {
+                if (scopes_.back() == Scope::Dependencies) {
+                    versions.back().value.dependencies = FlatMap<std::string_view, std::string_view>::fromUnsorted(
+                        std::move(dependencies_));
+                    dependencies_ = {};
+                }
+
+                scopes_.pop_back();
+            }
+
+            void onArrayBegin() override {
+                scopes_.push_back(Scope::Other);
+                nextScope_ = Scope::Other;
+                field_ = Field::None;
+            }
+
+            void onArrayEnd() override {
+                scopes_.pop_back();
+            }
+
+            bool onKey(const std::string_view key) override {
+                switch (scopes_.back()) {
+                    case Scope::Root:
+                        if (key == "name") {
+                            field_ = Field::Name;
+                            return true;
+                        }
+
+                        if (key == "versions") {
+                            nextScope_ = Scope::Versions;
+                            return true;
+                        }
+
+                        return false;
+                    case Scope::Versions:
+                        versions.push_back({strings.store(key), {}});
+                        nextScope_ = Scope::Version;
+                        return true;
+                    case Scope::Version:
+                        if (key == "version") {
+                            field_ = Field::Version;
+                            return true;
+                        }
+
+                        if (key == "dependencies") {
+                            nextScope_ = Scope::Dependencies;
+                            return true;
+                        }
+
+                        if (key == "dist") {
+                            nextScope_ = Scope::Dist;
+                            return true;
+                        }
+
+                        return false;
+                    case Scope::Dependencies:
+                        dependencyName_ = strings.store(key);
+                        field_ = Field::Dependency;
+                        return true;
+                    case Scope::Dist:
+                        if (key == "shasum") {
+                            field_ = Field::Shasum;
+                        } else if (key == "tarball") {
+                            field_ = Field::Tarball;
+                        } else if (key == "integrity") {
+                            field_ = Field::Integrity;
+                        } else {
+                            return false;
+                        }
+
+                        return true;
+                    default:
+                        return false;
+                }
+            }
+
+            void onString(const std::string_view value) override {
+                nextScope_ = Scope::Other;
+                switch (std::exchange(field_, Field::None)) {
+                    case Field::Name:
+                        name = value;
+                        break;
+                    case Field::Version:
+                        versions.back().value.version = strings.store(value);
+                        break;
+                    case Field::Dependency:
+                        dependencies_.emplace_back(dependencyName_, strings.store(value));
+                        break;
+                    case Field::Shasum:
+                        versions.back().value.dist.shasum = strings.store(value);
+                        break;
+                    case Field::Tarball:
+                        versions.back().value.dist.tarball = strings.store(value);
+                        break;
+                    case Field::Integrity:
+                        versions.back().value.dist.integrity = strings.store(value);
+                        break;
+                    default:
+                        break;
+                }
+            }
+
+            void onLiteral(std::string_view) override {
+                field_ = Field::None;
+                nextScope_ = Scope::Other;
+            }
+        };
+
+        // hands the body from the network thread over to the CPU pool. the write callback only appends the chunk,
+        // one drain job per transfer feeds whatever is pending to the parser in order, so the reactor never parses
+        // and a large packument doesn't stall the other transfers
+        class PackumentStream {
+            JsonStreamParser& parser_;
+
+            std::mutex lock_{};
+            std::string pending_{};
+            bool draining_{false};
+            bool transferDone_{false};
+            std::exception_ptr exception_{};
+            TaskCompletionSource<> drained_{};
+
+            // only touched by the drain job
+            std::string parsing_{};
+            std::chrono::microseconds parseTime_{};
+
+            void drain() {
+                while (true) {
+                    {
+                        std::lock_guard lock{lock_};
+                        parsing_.clear();
+                        std::swap(parsing_, pending_);
+                        if (exception_) {
+                            parsing_.clear();
+                        }
+
+                        if (parsing_.empty()) {
+                            draining_ = false;
+                            if (!transferDone_) {
+                                return;
+                            }
+                        }
+                    }
+
+                    if (parsing_.empty()) {
+                        // the transfer is over and everything it wrote is parsed
+                        drained_.setResult();
+                        return;
+                    }
+
+                    const auto begin = std::chrono::steady_clock::now();
+                    try {
+                        parser_.feed(parsing_);
+                    } catch (...) {
+                        std::lock_guard lock{lock_};
+                        exception_ = std::current_exception();
+                    }
+
+                    parseTime_ += std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - begin);
+                }
+            }
+
+        public:
+            explicit PackumentStream(JsonStreamParser& parser): parser_{parser} {
+            }
+
+            // network thread, false fails the transfer
+            bool write(const std::string_view chunk) {
+                {
+                    std::lock_guard lock{lock_};
+                    if (exception_) {
+                        return false;
+                    }
+
+                    pending_.append(chunk);
+                    if (std::exchange(draining_, true)) {
+                        return true;
+                    }
+                }
+
+                WorkStealingPool::getCpuPool().put([this] { drain(); });
+                return true;
+            }
+
+            // completes once every written chunk is parsed. call it after the transfer, even a failed one,
+            // and keep the stream alive until it completes
+            Task<> finish() {
+                bool drained;
+                {
+                    std::lock_guard lock{lock_};
+                    transferDone_ = true;
+                    drained = !draining_;
+                }
+
+                if (drained) {
+                    drained_.setResult();
+                }
+
+                return drained_.getTask();
+            }
+
+            [[nodiscard]] const std::exception_ptr& getException() const noexcept {
+                return exception_;
+            }
+
+            [[nodiscard]] std::chrono::microseconds getParseTime() const noexcept {
+                return parseTime_;
+            }
+        };
+    }
+
+    // runs on the network thread for every chunk, it only copies the chunk
+    static size_t curlPackumentWriter(const void* data, const size_t size, const size_t count,
+                                      void* typelessStreamPtr) {
+        auto* stream = static_cast<PackumentStream*>(typelessStreamPtr);
+        // 0 makes curl fail the transfer with CURLE_WRITE_ERROR
+        return stream->write({static_cast<const char*>(data), size * count}) ? size * count : 0;
+    }
+
+    NpmPackageInfo::NpmPackageInfo(std::string name, StringPool strings, std::vector<NpmVersionEntry> versions)
+        : strings_{std::move(strings)}, name_{std::move(name)}, versions_{std::move(versions)} {
+        std::ranges::sort(versions_, {}, &NpmVersionEntry::version);
+    }
+
+    const std::string& NpmPackageInfo::getName() const {
+        return name_;
+    }
+
+    const std::vector<NpmVersionEntry>& NpmPackageInfo::getVersions() const {
+        return versions_;
+    }
+
+    const NpmVersionEntry* NpmPackageInfo::findVersion(const std::string_view version) const {
+        const auto iter = std::ranges::lower_bound(versions_, version, {}, &NpmVersionEntry::version);
+        if (iter == versions_.end() || iter->version != version) {
+            return nullptr;
+        }
+
+        return &*iter;
+    }
+
     Task<NpmPackageInfo> npmFetchMetadata(const std::string_view url,
                                           const std::optional<std::string_view> username,
-                                          const std::optional<std::string_view> password) {
+                                          const std::optional<std::string_view> password,
+                                          CancellationToken cancellationToken) {
+        PackumentExtractor extractor{};
+        JsonStreamParser parser{extractor};
+        PackumentStream stream{parser};
+
+        std::exception_ptr transferException{};
         ZEPO_PERF_BEGIN_(queryNpmMetadata)
-        const auto response = co_await async_io::curlExecuteStringAsync([&](CURL* instance) {
-            curl_easy_setopt(instance, CURLOPT_URL, url.data());
-            curl_easy_setopt(instance, CURLOPT_NOSIGNAL, 1);
-            configureNpmAuth(instance, username, password);
-        });
+        try {
+            co_await async_io::curlExecuteAsync([&](CURL* instance) {
+                curl_easy_setopt(instance, CURLOPT_WRITEFUNCTION, curlPackumentWriter);
+                curl_easy_setopt(instance, CURLOPT_WRITEDATA, &stream);
+                curl_easy_setopt(instance, CURLOPT_URL, url.data());
+                curl_easy_setopt(instance, CURLOPT_NOSIGNAL, 1);
+                configureNpmAuth(instance, username, password);
+            }, std::move(cancellationToken));
+        } catch (...) {
+            transferException = std::current_exception();
+        }
+
+        // a drain job may still be parsing, wait for it even when the transfer failed
+        co_await stream.finish();
         ZEPO_PERF_END_(queryNpmMetadata)
 
-        ZEPO_PERF_BEGIN_(parseNpmMetadata)
-        const auto jsonDoc = JsonDocument{response};
-        auto result = parse<NpmPackageInfo>(jsonDoc.getRootToken());
-        ZEPO_PERF_END_(parseNpmMetadata)
+        // the part of the download spent parsing on the CPU pool
+        PerfDiagnostics::getDefault().pushTime("parseNpmMetadata", static_cast<long>(stream.getParseTime().count()));
+
+        // a parse error is what failed the transfer, report it instead of the write error
+        if (stream.getException()) {
+            std::rethrow_exception(stream.getException());
+        }
+
+        if (transferException) {
+            std::rethrow_exception(transferException);
+        }
+
+        co_await scheduleOn(WorkStealingPool::getCpuPool());
 
-        co_return result;
+        // a truncated body fails here
+        parser.finish();
+
+        co_return NpmPackageInfo{std::move(extractor.name), std::move(extractor.strings),
+                                 std::move(extractor.versions)};
     }
 
     Task<> npmDownloadTarball(const std::string_view url,
                               const std::optional<std::string_view> username,
                               const std::optional<std::string_view> password,
-                              std::iostream& output) {
+                              std::iostream& output,
+                              CancellationToken cancellationToken) {
         ZEPO_PERF_BEGIN_(downloadNpmTarball)
         co_await async_io::curlExecuteAsync([&](CURL* instance) {
             curl_easy_setopt(instance, CURLOPT_WRITEFUNCTION, curlStreamWriter);
@@ -74,7 +394,7 @@ namespace zepo {
             curl_easy_setopt(instance, CURLOPT_NOSIGNAL, 1);
             curl_easy_setopt(instance, CURLOPT_FOLLOWLOCATION, 1L);
             configureNpmAuth(instance, username, password);
-        });
+        }, std::move(cancellationToken));
         ZEPO_PERF_END_(downloadNpmTarball)
     }
 
@@ -98,9 +418,12 @@ namespace zepo {
     }
 
 
-    Task<> npmDecompressArchive(const std::filesystem::path& path, const std::filesystem::path& destination) {
-        co_await TaskUtils::run<void>([&] {
+    Task<std::vector<InstalledFile>> npmDecompressArchive(const std::filesystem::path& path,
+                                                          const std::filesystem::path& destination,
+                                                          CancellationToken cancellationToken) {
+        co_return co_await TaskUtils::run<std::vector<InstalledFile>>([&] {
             using namespace std::string_literals;
+            std::vector<InstalledFile> extractedFiles{};
             archive* archiveReader{archive_read_new()};
             archive_entry* entry;
             try {
@@ -112,6 +435,8 @@ namespace zepo {
                 }
 
                 while (true) {
+                    cancellationToken.throwIfCancellationRequested();
+
                     result = archive_read_next_header(archiveReader, &entry);
                     if (result == ARCHIVE_EOF) {
                         break;
@@ -136,14 +461,20 @@ namespace zepo {
                     if (result != ARCHIVE_OK) {
                         throw std::runtime_error("libarchive error: "s + archive_error_string(archiveReader));
                     }
+
+                    extractedFiles.push_back({
+                        archive_entry_pathname(entry),
+                        static_cast<uint64_t>(archive_entry_size(entry))
+                    });
                 }
 
                 archive_read_free(archiveReader);
+                return extractedFiles;
             } catch (...) {
                 const auto exception = std::current_exception();
                 archive_read_free(archiveReader);
                 std::rethrow_exception(exception);
             }
-        });
+        }, cancellationToken);
     }
 }
@@ -7,11 +7,17 @@
 #ifndef ZEPO_NPMPROTOCOL_HPP
 #define ZEPO_NPMPROTOCOL_HPP
 #include <filesystem>
-#include <map>
 #include <optional>
+#include <string_view>
+#include <vector>
 
+#include "InstallationManifest.hpp"
+#include "container/FlatMap.hpp"
+#include "container/StringPool.hpp"
+#include "serialize/Binary.hpp"
 #include "serialize/Serializer.hpp"
 #include "zepo/serialize/Reflect.hpp"
+#include "zepo/async/CancellationToken.hpp"
 #include "zepo/async/Task.hpp"
 
 namespace zepo {
@@ -19,42 +25,60 @@ namespace zepo {
     struct NpmPackageVersion;
     struct NpmPackageDist;
 
-    struct NpmPackageInfo {
-        std::string name;
-        std::map<std::string, NpmPackageVersion> versions;
-    };
-
+    // the strings point into the packument, or into the `NpmPackageInfo` they were extracted to
     struct NpmPackageDist {
-        std::string shasum;
-        std::string tarball;
-        std::string integrity;
+        std::string_view shasum;
+        std::string_view tarball;
+        std::string_view integrity;
     };
 
     struct NpmPackageVersion {
-        std::string version;
+        std::string_view version;
         NpmPackageDist dist;
-        std::map<std::string, std::string> dependencies;
+        FlatMap<std::string_view, std::string_view> dependencies;
     };
 
+    struct NpmVersionEntry {
+        std::string_view version;
+        NpmPackageVersion value;
+    };
+
+    // what the resolver needs out of a packument: its name and the version, dist and dependencies of
+    // every version, extracted while the packument downloads. the strings live in the info's own pool
+    class NpmPackageInfo {
+        StringPool strings_;
+        std::string name_;
+        std::vector<NpmVersionEntry> versions_;
+
+    public:
+        NpmPackageInfo(std::string name, StringPool strings, std::vector<NpmVersionEntry> versions);
+
+        [[nodiscard]] const std::string& getName() const;
+
+        // sorted by key
+        [[nodiscard]] const std::vector<NpmVersionEntry>& getVersions() const;
+
+        [[nodiscard]] const NpmVersionEntry* findVersion(std::string_view version) const;
+    };
+
+    // the packument is parsed as it arrives, nothing but the extracted fields is kept
     Task<NpmPackageInfo> npmFetchMetadata(std::string_view url,
                                           std::optional<std::string_view> username,
-                                          std::optional<std::string_view> password);
+                                          std::optional<std::string_view> password,
+                                          CancellationToken cancellationToken = {});
 
     Task<> npmDownloadTarball(std::string_view url,
                               std::optional<std::string_view> username,
                               std::optional<std::string_view> password,
-                              std::iostream& output);
+                              std::iostream& output,
+                              CancellationToken cancellationToken = {});
 
-    Task<> npmDecompressArchive(const std::filesystem::path& path, const std::filesystem::path& destination);
+    // stops between entries once `cancellationToken` is cancelled, leaving a partial destination behind
+    Task<std::vector<InstalledFile>> npmDecompressArchive(const std::filesystem::path& path,
+                                                          const std::filesystem::path& destination,
+                                                          CancellationToken cancellationToken = {});
 }
 
-ZEPO_REFLECT_INFO_BEGIN_(zepo::NpmPackageInfo)
-    ZEPO_REFLECT_FIELD_(name);
-    ZEPO_REFLECT_FIELD_(versions);
-ZEPO_REFLECT_INFO_END_()
-
-ZEPO_REFLECT_PARSABLE_(zepo::NpmPackageInfo);
-
 ZEPO_REFLECT_INFO_BEGIN_(zepo::NpmPackageVersion)
     ZEPO_REFLECT_FIELD_(version);
     ZEPO_REFLECT_FIELD_(dist);
@@ -71,4 +95,30 @@ ZEPO_REFLECT_INFO_END_()
 
 ZEPO_REFLECT_PARSABLE_(zepo::NpmPackageDist);
 
+ZEPO_REFLECT_INFO_BEGIN_(zepo::NpmVersionEntry)
+    ZEPO_REFLECT_FIELD_(version);
+    ZEPO_REFLECT_FIELD_(value);
+ZEPO_REFLECT_INFO_END_()
+
+// the strings of a decoded info point into the encoded buffer instead of its own pool, load it with
+// `zepo::loadBinary` to keep the two together
+template<>
+struct zepo::BinaryTraits<zepo::NpmPackageInfo> {
+    using Versions = std::vector<zepo::NpmVersionEntry>;
+
+    static constexpr uint64_t fingerprint = zepo::internal::mixFingerprint(
+        zepo::BinaryTraits<std::string>::fingerprint, zepo::BinaryTraits<Versions>::fingerprint);
+
+    static void encode(zepo::BinaryWriter& writer, const zepo::NpmPackageInfo& value) {
+        zepo::BinaryTraits<std::string>::encode(writer, value.getName());
+        zepo::BinaryTraits<Versions>::encode(writer, value.getVersions());
+    }
+
+    static zepo::NpmPackageInfo decode(zepo::BinaryReader& reader) {
+        auto name = zepo::BinaryTraits<std::string>::decode(reader);
+        auto versions = zepo::BinaryTraits<Versions>::decode(reader);
+        return {std::move(name), zepo::StringPool{}, std::move(versions)};
+    }
+};
+
 #endif //ZEPO_NPMPROTOCOL_HPP
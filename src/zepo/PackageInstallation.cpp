@@ -6,21 +6,140 @@
 
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <ranges>
 #include <optional>
+#include <utility>
 
 #include "Configuration.hpp"
 #include "Global.hpp"
+#include "InstallationManifest.hpp"
 #include "NpmProtocol.hpp"
+#include "async/TaskGroup.hpp"
 #include "async/TaskUtils.hpp"
 #include "diagnostics/PerfDiagnostics.hpp"
 #include "semver/Range.hpp"
 #include "semver/Semver.hpp"
+#include "serialize/Json.hpp"
 #include "serialize/Serializer.hpp"
+#include "storage/Durability.hpp"
 
 namespace zepo {
     using namespace std::string_literals;
 
+    // downloads and extractions running at the same time
+    static constexpr size_t maxConcurrentInstalls = 16;
+
+    static void getAuthOptions(std::optional<std::string_view>& authUsername,
+                               std::optional<std::string_view>& authPassword) {
+        if (globalConfiguration.authUsername.has_value()) {
+            authUsername = {globalConfiguration.authUsername.value()};
+        }
+
+        if (globalConfiguration.authPassword.has_value()) {
+            authPassword = {globalConfiguration.authPassword.value()};
+        }
+    }
+
+    std::filesystem::path getTarballStorePath(const std::string_view tarballUrl) {
+        return applicationPaths.downloadsPath / std::filesystem::path{tarballUrl}.filename();
+    }
+
+    std::filesystem::path getPackageStorePath(const std::string_view name, const std::string_view version) {
+        return applicationPaths.packagesPath / name / version;
+    }
+
+    Task<> storeDownloadTarball(const std::string_view tarballUrl, const std::filesystem::path& outputPath,
+                                CancellationToken cancellationToken) {
+        std::optional<std::string_view> authUsername;
+        std::optional<std::string_view> authPassword;
+        getAuthOptions(authUsername, authPassword);
+
+        auto partialPath = outputPath;
+        partialPath += ".part";
+
+        std::exception_ptr exception{};
+        {
+            std::fstream outputStream{partialPath, std::fstream::out | std::fstream::binary};
+            if (!outputStream.good()) {
+                throw std::runtime_error("failed to open " + partialPath.string() + " for package downloading");
+            }
+
+            try {
+                co_await npmDownloadTarball(tarballUrl, authUsername, authPassword, outputStream,
+                                            std::move(cancellationToken));
+            } catch (...) {
+                exception = std::current_exception();
+            }
+        }
+
+        // a partial body or an error page must never be renamed into the store
+        if (exception) {
+            co_await TaskUtils::run<void>([&] {
+                std::error_code error;
+                std::filesystem::remove(partialPath, error);
+            });
+            std::rethrow_exception(exception);
+        }
+
+        co_await TaskUtils::run<void>([&] {
+            std::filesystem::rename(partialPath, outputPath);
+        });
+    }
+
+    // the file system work runs on the blocking pool, it would hold up a CPU worker (and the resolution on it)
+    // for as long as the disk takes
+    Task<> storeExtractPackage(const std::filesystem::path& tarballPath, const std::filesystem::path& outputPath,
+                               InstallationManifest manifest, CancellationToken cancellationToken) {
+        auto stagingPath = outputPath;
+        stagingPath += ".staging";
+        co_await TaskUtils::run<void>([&] {
+            std::filesystem::remove_all(stagingPath);
+        });
+
+        manifest.files = co_await npmDecompressArchive(tarballPath, stagingPath, std::move(cancellationToken));
+
+        const auto lockContent = [&] {
+            JsonDocument lockDoc{};
+            lockDoc.setRoot(tokenify<JsonToken>(lockDoc, manifest));
+            return lockDoc.stringify();
+        }();
+
+        co_await TaskUtils::run<void>([&] {
+            {
+                std::ofstream lockStream{stagingPath / installationLockName, std::ios::out | std::ios::binary};
+                lockStream << lockContent;
+                if (!lockStream.good()) {
+                    throw std::runtime_error("failed to write installation lock to " + stagingPath.string());
+                }
+            }
+
+            if (globalDurabilityMode == storage::DurabilityMode::Package) {
+                ZEPO_PERF_BEGIN_(syncPackage)
+                storage::syncTree(stagingPath);
+                ZEPO_PERF_END_(syncPackage)
+            }
+
+            // leftovers of an extraction without the installation lock
+            std::filesystem::remove_all(outputPath);
+            std::filesystem::rename(stagingPath, outputPath);
+
+            if (globalDurabilityMode == storage::DurabilityMode::Package) {
+                ZEPO_PERF_BEGIN_(syncPackage)
+                storage::syncEntry(outputPath.parent_path());
+                ZEPO_PERF_END_(syncPackage)
+            }
+        });
+    }
+
+    PackageInstallingContext::PackageInstallingContext(const CancellationToken& cancellationToken)
+        : cancellation_{cancellationToken} {
+    }
+
+    void PackageInstallingContext::cancel() const {
+        cancellation_.cancel();
+    }
+
     const semver::Range& PackageInstallingContext::getRange(std::string_view expr) {
         if (const auto result = versionRangeCaches_.find(expr); result != versionRangeCaches_.end()) {
             return result->second;
@@ -46,24 +165,18 @@ namespace zepo {
 
             std::optional<std::string_view> authUsername;
             std::optional<std::string_view> authPassword;
-            if (globalConfiguration.authUsername.has_value()) {
-                authUsername = {globalConfiguration.authUsername.value()};
-            }
-
-            if (globalConfiguration.authPassword.has_value()) {
-                authPassword = {globalConfiguration.authPassword.value()};
-            }
+            getAuthOptions(authUsername, authPassword);
 
             const auto packageInfo =
                     co_await npmFetchMetadata(globalConfiguration.registry + "/" + std::string{name},
-                                              authUsername, authPassword);
+                                              authUsername, authPassword, cancellation_.getToken());
 
-            auto& versions = packageInfo.versions;
+            auto& versions = packageInfo.getVersions();
 
             ZEPO_PERF_BEGIN_(findSutiableVersion)
             auto iter = versions.rbegin();
             for (; iter != versions.rend(); ++iter) {
-                if (range.satisfies(semver::Version{iter->first}))
+                if (range.satisfies(semver::Version{iter->version}))
                     break;
             }
             ZEPO_PERF_END_(findSutiableVersion)
@@ -73,63 +186,85 @@ namespace zepo {
                 throw std::runtime_error("Failed to find suitable version for package: \"" + std::string{name} + "\"");
             }
 
+            const auto& selected = iter->value;
+
             packageSelect_.push_back({
                 std::string{source},
                 std::string{name},
                 std::string{version},
-                iter->first,
-                iter->second.dist.tarball
+                std::string{iter->version},
+                std::string{selected.dist.tarball},
+                std::string{selected.dist.integrity},
+                std::string{selected.dist.shasum}
             });
 
             // find depencencies
-            for (auto& [nextName, nextVersion]: iter->second.dependencies) {
+            for (auto& [nextName, nextVersion]: selected.dependencies) {
                 co_await addRequirement(name, nextName, nextVersion);
             }
         }
     }
 
 
-    Task<> PackageInstallingContext::resolveRequirements() {
-        ZEPO_PERF_BEGIN_(downloadPackages)
+    Task<> PackageInstallingContext::installPackage(const PackageSelect& select,
+                                                    const CancellationToken cancellationToken) {
+        // download
+        const auto downloadOutputPath = getTarballStorePath(select.tarball);
+        const auto downloadOutputPathStr = downloadOutputPath.string();
 
-        // std::map<std::string, int>
+        do {
+            if (co_await TaskUtils::run<bool>([&] { return exists(downloadOutputPath); })) break;
 
-        std::optional<std::string_view> authUsername;
-        std::optional<std::string_view> authPassword;
-        if (globalConfiguration.authUsername.has_value()) {
-            authUsername = {globalConfiguration.authUsername.value()};
-        }
+            std::cout << "downloading: " << select.tarball << " to " << downloadOutputPathStr << std::endl;
+            co_await storeDownloadTarball(select.tarball, downloadOutputPath, cancellationToken);
+        } while (false);
 
-        if (globalConfiguration.authPassword.has_value()) {
-            authPassword = {globalConfiguration.authPassword.value()};
-        }
+        // extract
+        const auto extractOutputPath = getPackageStorePath(select.name, select.selected);
+        do {
+            if (co_await TaskUtils::run<bool>([&] { return exists(extractOutputPath / installationLockName); })) break;
+            std::cout << "extracting: " << downloadOutputPathStr << " to " << extractOutputPath.string() << std::endl;
+
+            co_await storeExtractPackage(downloadOutputPath, extractOutputPath, {
+                                             select.name,
+                                             select.selected,
+                                             select.tarball,
+                                             select.integrity,
+                                             select.shasum,
+                                             {}
+                                         }, cancellationToken);
 
-        for (const auto& select: packageSelect_) {
-            // download
-            const auto downloadOutputPath = applicationPaths.downloadsPath / std::filesystem::path{select.tarball}.
-                                            filename();
-            const auto downloadOutputPathStr = downloadOutputPath.string();
+            std::lock_guard lock{extractedPathsLock_};
+            extractedPaths_.push_back(extractOutputPath);
+        } while (false);
+    }
 
-            do {
-                if (exists(downloadOutputPath)) break;
+    Task<> PackageInstallingContext::resolveRequirements() {
+        ZEPO_PERF_BEGIN_(downloadPackages)
 
-                std::cout << "downloading: " << select.tarball << " to " << downloadOutputPathStr << std::endl;
-                std::fstream outputStream{downloadOutputPath, std::fstream::out | std::fstream::binary};
-                if (!outputStream.good()) {
-                    throw std::runtime_error("failed to open " + downloadOutputPathStr + " for package downloading");
-                }
+        {
+            // the first failure cancels the packages still in flight
+            TaskGroup group{maxConcurrentInstalls, cancellation_.getToken()};
 
-                co_await npmDownloadTarball(select.tarball, authUsername, authPassword, outputStream);
-            } while (false);
+            // a package required from several places is installed once, two children would race on its paths
+            std::set<std::pair<std::string_view, std::string_view>> spawned{};
+            for (const auto& select: packageSelect_) {
+                if (!spawned.emplace(select.name, select.selected).second) continue;
 
-            // extract
-            const auto extractOutputPath = applicationPaths.packagesPath / select.name / select.selected;
-            do {
-                if (exists(extractOutputPath / "zepo-installation.lock")) break;
-                std::cout << "extracting: " << downloadOutputPathStr << " to " << extractOutputPath.string() << std::endl;
+                group.spawn([this, &select](const CancellationToken& token) {
+                    return installPackage(select, token);
+                });
+            }
+
+            co_await group.join();
+        }
 
-                co_await npmDecompressArchive(downloadOutputPath, extractOutputPath);
-            } while (false);
+        if (globalDurabilityMode == storage::DurabilityMode::Install && !extractedPaths_.empty()) {
+            ZEPO_PERF_BEGIN_(syncInstall)
+            co_await TaskUtils::run<void>([this] {
+                storage::syncTrees(extractedPaths_);
+            });
+            ZEPO_PERF_END_(syncInstall)
         }
 
         ZEPO_PERF_END_(downloadPackages)
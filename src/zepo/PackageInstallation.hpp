@@ -5,16 +5,36 @@
 #pragma once
 #ifndef ZEPO_PACKAGEINSTALLATION_HPP
 #define ZEPO_PACKAGEINSTALLATION_HPP
-#include <map>
+#include <filesystem>
+#include <mutex>
 #include <set>
 #include <string>
 #include <string_view>
+#include <vector>
 
+#include "async/CancellationToken.hpp"
 #include "async/Task.hpp"
+#include "container/HashMap.hpp"
 #include "semver/Range.hpp"
 
 namespace zepo {
     struct NpmPackageInfo;
+    struct InstallationManifest;
+
+    inline constexpr std::string_view installationLockName{"zepo-installation.lock"};
+
+    std::filesystem::path getTarballStorePath(std::string_view tarballUrl);
+
+    std::filesystem::path getPackageStorePath(std::string_view name, std::string_view version);
+
+    // download into "<path>.part" first, so an interrupted download never looks like a cached tarball
+    Task<> storeDownloadTarball(std::string_view tarballUrl, const std::filesystem::path& outputPath,
+                                CancellationToken cancellationToken = {});
+
+    // extract the tarball into a staging directory, record the extracted files to the installation lock,
+    // then rename it into place. with the "package" durability mode the staging directory is synced first
+    Task<> storeExtractPackage(const std::filesystem::path& tarballPath, const std::filesystem::path& outputPath,
+                               InstallationManifest manifest, CancellationToken cancellationToken = {});
 
     class PackageInstallingContext {
         struct PackageSelect {
@@ -24,16 +44,30 @@ namespace zepo {
             std::string selected;
 
             std::string tarball;
+            std::string integrity;
+            std::string shasum;
         };
 
-        std::map<std::string, semver::Range, std::less<>> versionRangeCaches_{};
+        HashMap<std::string, semver::Range> versionRangeCaches_{};
         std::vector<PackageSelect> packageSelect_{};
+        std::mutex extractedPathsLock_{};
+        std::vector<std::filesystem::path> extractedPaths_{};
+        CancellationSource cancellation_;
 
         const semver::Range& getRange(std::string_view expr);
 
+        Task<> installPackage(const PackageSelect& select, CancellationToken cancellationToken);
+
     public:
+        // cancelling `cancellationToken` also cancels the installation
+        explicit PackageInstallingContext(const CancellationToken& cancellationToken = {});
+
+        // stop the outstanding downloads and extractions, they fail with OperationCancelledException
+        void cancel() const;
+
         Task<> addRequirement(std::string_view source, std::string_view name, std::string_view version);
 
+        // downloads and extracts the selected packages concurrently
         Task<> resolveRequirements();
     };
 }
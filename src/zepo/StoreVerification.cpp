@@ -0,0 +1,236 @@
+//
+// Created by qingy on 2024/8/3.
+//
+
+#include "StoreVerification.hpp"
+
+#include <chrono>
+#include <iostream>
+
+#include "Global.hpp"
+#include "PackageInstallation.hpp"
+#include "async/TaskUtils.hpp"
+#include "crypto/Integrity.hpp"
+#include "diagnostics/PerfDiagnostics.hpp"
+#include "serialize/Json.hpp"
+#include "serialize/Serializer.hpp"
+#include "storage/Durability.hpp"
+
+namespace zepo {
+    static crypto::Integrity getRecordedIntegrity(const InstallationManifest& manifest) {
+        if (!manifest.integrity.empty()) {
+            return crypto::Integrity::fromSubresource(manifest.integrity);
+        }
+
+        if (!manifest.shasum.empty()) {
+            return crypto::Integrity::fromShasum(manifest.shasum);
+        }
+
+        return crypto::Integrity{};
+    }
+
+    StoreVerifyingContext::StoreVerifyingContext(const int concurrency)
+        : concurrency_{concurrency > 0 ? concurrency : 1} {
+    }
+
+    void StoreVerifyingContext::collectEntries() {
+        using namespace std::filesystem;
+
+        for (auto iter = recursive_directory_iterator{applicationPaths.packagesPath};
+             iter != recursive_directory_iterator{}; ++iter) {
+            if (!iter->is_directory()) continue;
+
+            // interrupted extraction, the next install starts it over
+            if (iter->path().filename().string().ends_with(".staging")) {
+                iter.disable_recursion_pending();
+                continue;
+            }
+
+            const auto lockPath = iter->path() / installationLockName;
+            if (!exists(lockPath)) continue;
+
+            // a package never contains another package
+            iter.disable_recursion_pending();
+
+            try {
+                const auto lockDoc = JsonDocument::fromFile(lockPath);
+                entries_.push_back({iter->path(), parse<InstallationManifest>(lockDoc.getRootToken())});
+            } catch (const std::runtime_error&) {
+                unreadableLocks_.push_back(lockPath);
+            }
+        }
+    }
+
+    void StoreVerifyingContext::verifyEntry(StoreEntry& entry) {
+        // tarball
+        const auto tarballPath = getTarballStorePath(entry.manifest.tarball);
+        if (std::error_code error; !exists(tarballPath, error)) {
+            entry.tarballBroken = true;
+            entry.reason = "tarball missing";
+        } else {
+            // a malformed or unsupported record breaks this entry only, not the whole verification
+            try {
+                // nothing recorded to compare with, keep it as long as it exists
+                if (const auto integrity = getRecordedIntegrity(entry.manifest); !integrity.empty()) {
+                    uint64_t bytesRead{0};
+                    const auto matches = integrity.matches(tarballPath, bytesRead);
+                    bytesHashed_ += bytesRead;
+
+                    if (!matches) {
+                        entry.tarballBroken = true;
+                        entry.reason = "tarball " + integrity.getAlgorithm() + " mismatch";
+                    }
+                }
+            } catch (const std::exception& e) {
+                entry.tarballBroken = true;
+                entry.reason = e.what();
+            }
+        }
+
+        // extracted tree
+        for (const auto& file: entry.manifest.files) {
+            std::error_code error;
+            const auto size = file_size(entry.packagePath / file.path, error);
+            filesChecked_++;
+
+            if (error || size != file.size) {
+                entry.treeBroken = true;
+                if (!entry.reason.empty()) entry.reason += ", ";
+                entry.reason += "\"" + file.path + "\" " + (error ? "missing" : "truncated");
+                break;
+            }
+        }
+    }
+
+    void StoreVerifyingContext::verifyWorker() {
+        for (auto index = nextEntry_++; index < entries_.size(); index = nextEntry_++) {
+            verifyEntry(entries_[index]);
+        }
+    }
+
+    Task<> StoreVerifyingContext::verify() {
+        ZEPO_PERF_BEGIN_(verifyStore)
+        const auto beginTime = std::chrono::steady_clock::now();
+
+        co_await TaskUtils::run<void>([this] { collectEntries(); });
+
+        // every worker pulls the next entry on its own, so at most `concurrency_` entries are in flight
+        std::vector<Task<>> workers{};
+        for (int i = 0; i < concurrency_; ++i) {
+            workers.push_back(TaskUtils::run<void>([this] { verifyWorker(); }));
+        }
+
+        co_await TaskUtils::whenAll(workers);
+
+        elapsedMicroseconds_ = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - beginTime).count();
+        ZEPO_PERF_END_(verifyStore)
+    }
+
+    Task<> StoreVerifyingContext::repair() {
+        ZEPO_PERF_BEGIN_(repairStore)
+        // without a readable lock we cannot tell where the package came from, let the next install redo it
+        for (const auto& lockPath: unreadableLocks_) {
+            std::cout << "removing: " << lockPath.parent_path().string() << std::endl;
+            co_await TaskUtils::run<void>([&] { std::filesystem::remove_all(lockPath.parent_path()); });
+        }
+        unreadableLocks_.clear();
+
+        std::vector<std::filesystem::path> repairedPaths{};
+        size_t failedCount{0};
+        for (auto& entry: entries_) {
+            if (!entry.tarballBroken && !entry.treeBroken) continue;
+
+            // one package that can't be repaired doesn't stop the others
+            try {
+                co_await repairEntry(entry);
+                repairedPaths.push_back(entry.packagePath);
+            } catch (const std::exception& e) {
+                entry.reason = e.what();
+                failedCount++;
+            }
+        }
+
+        if (globalDurabilityMode == storage::DurabilityMode::Install && !repairedPaths.empty()) {
+            co_await TaskUtils::run<void>([&] { storage::syncTrees(repairedPaths); });
+        }
+        ZEPO_PERF_END_(repairStore)
+
+        if (failedCount > 0) {
+            for (const auto& entry: entries_) {
+                if (!entry.tarballBroken && !entry.treeBroken) continue;
+                std::cout << "repair failed: " << entry.manifest.name << "@" << entry.manifest.version
+                        << " (" << entry.reason << ")\n";
+            }
+
+            std::cout << std::flush;
+            throw std::runtime_error("failed to repair " + std::to_string(failedCount) + " package(s)");
+        }
+    }
+
+    Task<> StoreVerifyingContext::repairEntry(StoreEntry& entry) {
+        const auto tarballPath = getTarballStorePath(entry.manifest.tarball);
+        if (entry.tarballBroken) {
+            std::cout << "re-fetching: " << entry.manifest.tarball << std::endl;
+            co_await TaskUtils::run<void>([&] { std::filesystem::remove(tarballPath); });
+            co_await storeDownloadTarball(entry.manifest.tarball, tarballPath);
+
+            const auto matches = co_await TaskUtils::run<bool>([&] {
+                uint64_t bytesRead{0};
+                const auto integrity = getRecordedIntegrity(entry.manifest);
+                return integrity.empty() || integrity.matches(tarballPath, bytesRead);
+            });
+
+            if (!matches) {
+                co_await TaskUtils::run<void>([&] { std::filesystem::remove(tarballPath); });
+                throw std::runtime_error("integrity mismatch after re-fetching " + entry.manifest.tarball);
+            }
+        }
+
+        // either the tree itself is broken, or it came from a tarball we no longer trust. the old tree is only
+        // replaced once the new one is staged, a failed extraction leaves it as it was
+        std::cout << "re-extracting: " << entry.packagePath.string() << std::endl;
+        co_await storeExtractPackage(tarballPath, entry.packagePath, entry.manifest);
+
+        entry.tarballBroken = false;
+        entry.treeBroken = false;
+        entry.reason.clear();
+    }
+
+    size_t StoreVerifyingContext::getBrokenCount() const {
+        size_t count{0};
+        for (const auto& entry: entries_) {
+            if (entry.tarballBroken || entry.treeBroken) count++;
+        }
+
+        return count;
+    }
+
+    void StoreVerifyingContext::printReport() const {
+        for (const auto& lockPath: unreadableLocks_) {
+            std::cout << "unreadable: " << lockPath.string() << "\n";
+        }
+
+        for (const auto& entry: entries_) {
+            if (!entry.tarballBroken && !entry.treeBroken) continue;
+            std::cout << "broken: " << entry.manifest.name << "@" << entry.manifest.version
+                    << " (" << entry.reason << ")\n";
+        }
+
+        const auto seconds = static_cast<double>(elapsedMicroseconds_) / 1000000.0;
+        const auto megabytes = static_cast<double>(bytesHashed_) / (1024.0 * 1024.0);
+
+        std::cout << "== store verification ==\n"
+                << "packages: " << entries_.size() << ", broken: " << getBrokenCount()
+                << ", unreadable: " << unreadableLocks_.size() << "\n"
+                << "files checked: " << filesChecked_ << ", hashed: " << megabytes << "MiB\n"
+                << "elapsed: " << elapsedMicroseconds_ << "us, concurrency: " << concurrency_ << "\n";
+
+        if (seconds > 0) {
+            std::cout << "throughput: " << megabytes / seconds << "MiB/s, "
+                    << static_cast<double>(entries_.size()) / seconds << " packages/s\n";
+        }
+
+        std::cout << std::flush;
+    }
+}
@@ -0,0 +1,60 @@
+//
+// Created by qingy on 2024/8/3.
+//
+
+#pragma once
+#ifndef ZEPO_STOREVERIFICATION_HPP
+#define ZEPO_STOREVERIFICATION_HPP
+#include <atomic>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "InstallationManifest.hpp"
+#include "async/Task.hpp"
+
+namespace zepo {
+    class StoreVerifyingContext {
+        struct StoreEntry {
+            std::filesystem::path packagePath;
+            InstallationManifest manifest;
+
+            bool tarballBroken{false};
+            bool treeBroken{false};
+            std::string reason{};
+        };
+
+        int concurrency_;
+        std::vector<StoreEntry> entries_{};
+        std::vector<std::filesystem::path> unreadableLocks_{};
+
+        std::atomic<size_t> nextEntry_{0};
+        std::atomic<uint64_t> bytesHashed_{0};
+        std::atomic<uint64_t> filesChecked_{0};
+        long elapsedMicroseconds_{0};
+
+        void collectEntries();
+
+        void verifyEntry(StoreEntry& entry);
+
+        void verifyWorker();
+
+        Task<> repairEntry(StoreEntry& entry);
+
+    public:
+        // `concurrency` bounds how many entries are read from disk at the same time
+        explicit StoreVerifyingContext(int concurrency);
+
+        Task<> verify();
+
+        // re-fetch broken tarballs and re-extract broken trees, nothing else is touched.
+        // every broken entry is attempted, throws afterwards if some of them could not be repaired
+        Task<> repair();
+
+        [[nodiscard]] size_t getBrokenCount() const;
+
+        void printReport() const;
+    };
+}
+
+#endif //ZEPO_STOREVERIFICATION_HPP
@@ -5,6 +5,8 @@
 #ifndef ZEPO_ASYNCIO_HPP
 #define ZEPO_ASYNCIO_HPP
 #include <span>
+#include <sstream>
+#include <string>
 
 #include "Task.hpp"
 #include "TaskUtils.hpp"
@@ -18,9 +20,22 @@ namespace zepo::async_io {
         });
     }
 
+    // a seekable stream is read in one go into a string of its size, others are drained through a stringstream
     template<typename StreamType>
     Task<std::string> readString(StreamType& stream) {
         co_return co_await TaskUtils::run<std::string>([&] {
+            const auto begin = stream.tellg();
+            if (begin != std::streampos{-1} && stream.seekg(0, std::ios::end)) {
+                const auto end = stream.tellg();
+                stream.seekg(begin);
+
+                std::string result(static_cast<size_t>(end - begin), '\0');
+                stream.read(result.data(), static_cast<std::streamsize>(result.size()));
+                result.resize(static_cast<size_t>(stream.gcount()));
+                return result;
+            }
+
+            stream.clear();
             std::stringstream sstream;
             sstream << stream.rdbuf();
             return sstream.str();
@@ -0,0 +1,133 @@
+//
+// Created by qingy on 2024/8/14.
+//
+
+#pragma once
+#ifndef ZEPO_ASYNCSEMAPHORE_HPP
+#define ZEPO_ASYNCSEMAPHORE_HPP
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+#include "zepo/async/Executor.hpp"
+
+namespace zepo
+{
+    // counting semaphore for coroutines. acquiring an available permit and releasing without waiters
+    // are a single atomic operation, the lock is only taken to park or wake a waiter
+    class AsyncSemaphore
+    {
+        struct Waiter
+        {
+            std::coroutine_handle<> handle;
+            Executor* executor;
+        };
+
+        std::atomic<int64_t> available_;
+        std::atomic<int64_t> waiterCount_{0};
+
+        std::mutex lock_{};
+        std::deque<Waiter> waiters_{};
+
+    public:
+        class AcquireAwaiter
+        {
+            AsyncSemaphore& semaphore_;
+
+        public:
+            explicit AcquireAwaiter(AsyncSemaphore& semaphore) : semaphore_{semaphore}
+            {
+            }
+
+            [[nodiscard]] bool await_ready() const noexcept
+            {
+                return semaphore_.tryAcquire();
+            }
+
+            bool await_suspend(const std::coroutine_handle<> handle) const
+            {
+                std::lock_guard lock{semaphore_.lock_};
+
+                // announce first, a release either sees us or we see its permit. `tryAcquire` starts with a
+                // relaxed load, the fence keeps it from being satisfied before the announcement is visible
+                semaphore_.waiterCount_.fetch_add(1, std::memory_order_seq_cst);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (semaphore_.tryAcquire())
+                {
+                    semaphore_.waiterCount_.fetch_sub(1, std::memory_order_relaxed);
+                    return false;
+                }
+
+                semaphore_.waiters_.push_back({handle, Executor::getCurrent()});
+                return true;
+            }
+
+            void await_resume() const noexcept
+            {
+            }
+        };
+
+        explicit AsyncSemaphore(const int64_t permits) : available_{permits}
+        {
+        }
+
+        AsyncSemaphore(const AsyncSemaphore&) = delete;
+
+        AsyncSemaphore(AsyncSemaphore&&) = delete;
+
+        [[nodiscard]] bool tryAcquire() noexcept
+        {
+            auto available = available_.load(std::memory_order_relaxed);
+            while (available > 0)
+            {
+                if (available_.compare_exchange_weak(available, available - 1, std::memory_order_seq_cst,
+                                                     std::memory_order_relaxed))
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        // `co_await semaphore.acquire()`, resumes on the executor it was awaited from
+        [[nodiscard]] AcquireAwaiter acquire() noexcept
+        {
+            return AcquireAwaiter{*this};
+        }
+
+        void release(int64_t count = 1)
+        {
+            available_.fetch_add(count, std::memory_order_seq_cst);
+            // pairs with the fence in `await_suspend`, either side observes the other's write
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (waiterCount_.load(std::memory_order_seq_cst) == 0) return;
+
+            // hand the permits over to the waiters in arrival order
+            while (count-- > 0)
+            {
+                Waiter waiter{};
+                {
+                    std::lock_guard lock{lock_};
+                    if (waiters_.empty() || !tryAcquire()) return;
+
+                    waiter = waiters_.front();
+                    waiters_.pop_front();
+                    waiterCount_.fetch_sub(1, std::memory_order_relaxed);
+                }
+
+                internal::resumeOn(waiter.executor, waiter.handle);
+            }
+        }
+
+        [[nodiscard]] int64_t getAvailable() const noexcept
+        {
+            return available_.load(std::memory_order_relaxed);
+        }
+    };
+}
+
+#endif //ZEPO_ASYNCSEMAPHORE_HPP
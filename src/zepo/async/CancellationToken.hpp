@@ -0,0 +1,113 @@
+//
+// Created by qingy on 2024/8/9.
+//
+
+#pragma once
+#ifndef ZEPO_CANCELLATIONTOKEN_HPP
+#define ZEPO_CANCELLATIONTOKEN_HPP
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+
+namespace zepo
+{
+    class OperationCancelledException : public std::runtime_error
+    {
+    public:
+        OperationCancelledException() : std::runtime_error("operation cancelled")
+        {
+        }
+    };
+
+    namespace internal
+    {
+        // cancellation is only a flag, so requesting it is lock-free and safe from a signal handler.
+        // observers poll it at their own checkpoints (curl progress, archive entries, queued jobs)
+        struct CancellationState
+        {
+            std::atomic<bool> cancelled{false};
+            std::shared_ptr<const CancellationState> parent{};
+
+            [[nodiscard]] bool isCancelled() const noexcept
+            {
+                for (auto* state = this; state != nullptr; state = state->parent.get())
+                {
+                    if (state->cancelled.load(std::memory_order_acquire)) return true;
+                }
+
+                return false;
+            }
+        };
+    }
+
+    class CancellationToken
+    {
+        std::shared_ptr<const internal::CancellationState> state_{};
+
+    public:
+        // a default constructed token is never cancelled
+        CancellationToken() = default;
+
+        explicit CancellationToken(std::shared_ptr<const internal::CancellationState> state) : state_{
+            std::move(state)
+        }
+        {
+        }
+
+        [[nodiscard]] bool isCancellationRequested() const noexcept
+        {
+            return state_ != nullptr && state_->isCancelled();
+        }
+
+        void throwIfCancellationRequested() const
+        {
+            if (isCancellationRequested())
+            {
+                throw OperationCancelledException{};
+            }
+        }
+
+        [[nodiscard]] const std::shared_ptr<const internal::CancellationState>& getState() const noexcept
+        {
+            return state_;
+        }
+    };
+
+    class CancellationSource
+    {
+        std::shared_ptr<internal::CancellationState> state_{std::make_shared<internal::CancellationState>()};
+
+    public:
+        CancellationSource() = default;
+
+        // cancelled together with `parent`, but cancelling this source leaves the parent alone
+        explicit CancellationSource(const CancellationToken& parent)
+        {
+            state_->parent = parent.getState();
+        }
+
+        CancellationSource(const CancellationSource&) = delete;
+
+        CancellationSource(CancellationSource&&) noexcept = default;
+
+        CancellationSource& operator=(CancellationSource&&) noexcept = default;
+
+        void cancel() const noexcept
+        {
+            state_->cancelled.store(true, std::memory_order_release);
+        }
+
+        [[nodiscard]] bool isCancellationRequested() const noexcept
+        {
+            return state_->isCancelled();
+        }
+
+        [[nodiscard]] CancellationToken getToken() const
+        {
+            return CancellationToken{state_};
+        }
+    };
+}
+
+#endif //ZEPO_CANCELLATIONTOKEN_HPP
@@ -0,0 +1,215 @@
+//
+// Created by qingy on 2024/8/14.
+//
+
+#pragma once
+#ifndef ZEPO_CHANNEL_HPP
+#define ZEPO_CHANNEL_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+
+#include "zepo/async/AsyncSemaphore.hpp"
+#include "zepo/async/Task.hpp"
+
+namespace zepo
+{
+    class ChannelClosedException : public std::runtime_error
+    {
+    public:
+        ChannelClosedException() : std::runtime_error("channel closed")
+        {
+        }
+    };
+
+    namespace internal
+    {
+        // Vyukov's bounded MPMC queue, callers make sure it is never pushed when full or popped when empty
+        template <typename ValueType>
+        class BoundedQueue
+        {
+            struct Cell
+            {
+                std::atomic<size_t> sequence;
+                std::optional<ValueType> value;
+            };
+
+            size_t mask_;
+            std::unique_ptr<Cell[]> cells_;
+            alignas(64) std::atomic<size_t> enqueuePosition_{0};
+            alignas(64) std::atomic<size_t> dequeuePosition_{0};
+
+        public:
+            explicit BoundedQueue(const size_t capacity)
+            {
+                size_t size = 1;
+                while (size < capacity) size <<= 1;
+
+                mask_ = size - 1;
+                cells_ = std::make_unique<Cell[]>(size);
+                for (size_t i = 0; i < size; ++i)
+                {
+                    cells_[i].sequence.store(i, std::memory_order_relaxed);
+                }
+            }
+
+            template <typename... Args>
+            void push(Args&&... args)
+            {
+                auto position = enqueuePosition_.load(std::memory_order_relaxed);
+                Cell* cell;
+                while (true)
+                {
+                    cell = &cells_[position & mask_];
+                    const auto sequence = cell->sequence.load(std::memory_order_acquire);
+                    const auto difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+                    if (difference == 0)
+                    {
+                        if (enqueuePosition_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                            break;
+                    }
+                    else
+                    {
+                        position = enqueuePosition_.load(std::memory_order_relaxed);
+                    }
+                }
+
+                cell->value.emplace(std::forward<Args>(args)...);
+                cell->sequence.store(position + 1, std::memory_order_release);
+            }
+
+            ValueType pop()
+            {
+                auto position = dequeuePosition_.load(std::memory_order_relaxed);
+                Cell* cell;
+                while (true)
+                {
+                    cell = &cells_[position & mask_];
+                    const auto sequence = cell->sequence.load(std::memory_order_acquire);
+                    const auto difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position + 1);
+                    if (difference == 0)
+                    {
+                        if (dequeuePosition_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                            break;
+                    }
+                    else
+                    {
+                        position = dequeuePosition_.load(std::memory_order_relaxed);
+                    }
+                }
+
+                ValueType value{std::move(*cell->value)};
+                cell->value.reset();
+                cell->sequence.store(position + mask_ + 1, std::memory_order_release);
+                return value;
+            }
+        };
+    }
+
+    // bounded multi-producer multi-consumer channel, senders wait while it is full (backpressure),
+    // receivers wait while it is empty. both directions are lock-free unless they have to wait
+    template <typename ValueType>
+    class Channel
+    {
+        internal::BoundedQueue<ValueType> queue_;
+        AsyncSemaphore freeSlots_;
+        AsyncSemaphore usedSlots_{0};
+        std::atomic<int64_t> queued_{0};
+        std::atomic<bool> closed_{false};
+
+    public:
+        explicit Channel(const size_t capacity)
+            : queue_{capacity}, freeSlots_{static_cast<int64_t>(capacity)}
+        {
+        }
+
+        Channel(const Channel&) = delete;
+
+        Channel(Channel&&) = delete;
+
+        [[nodiscard]] bool trySend(ValueType value)
+        {
+            if (closed_.load(std::memory_order_acquire))
+            {
+                throw ChannelClosedException{};
+            }
+
+            if (!freeSlots_.tryAcquire()) return false;
+
+            queue_.push(std::move(value));
+            queued_.fetch_add(1, std::memory_order_release);
+            usedSlots_.release();
+            return true;
+        }
+
+        // throws ChannelClosedException once the channel is closed
+        Task<> send(ValueType value)
+        {
+            co_await freeSlots_.acquire();
+            if (closed_.load(std::memory_order_acquire))
+            {
+                // pass the wake-up on to the next blocked sender
+                freeSlots_.release();
+                throw ChannelClosedException{};
+            }
+
+            queue_.push(std::move(value));
+            queued_.fetch_add(1, std::memory_order_release);
+            usedSlots_.release();
+        }
+
+        [[nodiscard]] std::optional<ValueType> tryReceive()
+        {
+            if (!usedSlots_.tryAcquire()) return std::nullopt;
+
+            return takeSlot();
+        }
+
+        // returns nullopt once the channel is closed and drained
+        Task<std::optional<ValueType>> receive()
+        {
+            co_await usedSlots_.acquire();
+            co_return takeSlot();
+        }
+
+        // the items already sent can still be received
+        void close()
+        {
+            if (closed_.exchange(true, std::memory_order_acq_rel)) return;
+
+            // one extra permit each, woken waiters see the flag and pass it on
+            freeSlots_.release();
+            usedSlots_.release();
+        }
+
+        [[nodiscard]] bool isClosed() const noexcept
+        {
+            return closed_.load(std::memory_order_acquire);
+        }
+
+    private:
+        std::optional<ValueType> takeSlot()
+        {
+            // the permit `close` added has no item behind it
+            auto queued = queued_.load(std::memory_order_acquire);
+            do
+            {
+                if (queued == 0)
+                {
+                    usedSlots_.release();
+                    return std::nullopt;
+                }
+            } while (!queued_.compare_exchange_weak(queued, queued - 1, std::memory_order_acq_rel));
+
+            auto value = queue_.pop();
+            freeSlots_.release();
+            return value;
+        }
+    };
+}
+
+#endif //ZEPO_CHANNEL_HPP
@@ -0,0 +1,97 @@
+//
+// Created by qingy on 2024/8/13.
+//
+
+#pragma once
+#ifndef ZEPO_EXECUTOR_HPP
+#define ZEPO_EXECUTOR_HPP
+
+#include <coroutine>
+#include <functional>
+
+namespace zepo
+{
+    class Executor;
+
+    namespace internal
+    {
+        inline thread_local Executor* currentExecutor{nullptr};
+    }
+
+    // somewhere to run jobs and resume coroutines: the CPU pool, the blocking I/O pool or the network reactor
+    class Executor
+    {
+    public:
+        using Action = std::function<void()>;
+
+        Executor() = default;
+
+        Executor(const Executor&) = delete;
+
+        Executor(Executor&&) = delete;
+
+        virtual ~Executor() = default;
+
+        virtual void put(Action&& action) = 0;
+
+        // the executor running the calling thread, nullptr outside of executors
+        static Executor* getCurrent() noexcept
+        {
+            return internal::currentExecutor;
+        }
+
+    protected:
+        // executor threads call this once when they start running
+        static void setCurrent(Executor* executor) noexcept
+        {
+            internal::currentExecutor = executor;
+        }
+    };
+
+    namespace internal
+    {
+        // resume `handle` on `executor`, right here when we already run on it or it has none
+        inline void resumeOn(Executor* executor, const std::coroutine_handle<> handle)
+        {
+            if (executor != nullptr && executor != Executor::getCurrent())
+            {
+                executor->put([handle] { handle.resume(); });
+                return;
+            }
+
+            handle.resume();
+        }
+    }
+
+    class ScheduleAwaiter
+    {
+        Executor& executor_;
+
+    public:
+        explicit ScheduleAwaiter(Executor& executor) : executor_{executor}
+        {
+        }
+
+        [[nodiscard]] bool await_ready() const noexcept
+        {
+            return Executor::getCurrent() == &executor_;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) const
+        {
+            executor_.put([handle] { handle.resume(); });
+        }
+
+        void await_resume() const noexcept
+        {
+        }
+    };
+
+    // `co_await scheduleOn(executor)` continues the coroutine on `executor`, awaits after it resume there too
+    inline ScheduleAwaiter scheduleOn(Executor& executor)
+    {
+        return ScheduleAwaiter{executor};
+    }
+}
+
+#endif //ZEPO_EXECUTOR_HPP
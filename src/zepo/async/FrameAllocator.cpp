@@ -0,0 +1,147 @@
+//
+// Created by qingy on 2024/8/12.
+//
+
+#include "FrameAllocator.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace zepo::internal {
+    namespace {
+        constexpr std::size_t sizeClassGranularity = 64;
+        constexpr std::size_t sizeClassCount = 16; // up to 1k
+        constexpr std::size_t maxCachedFrames = 256; // per size class and thread
+
+        struct FreeFrame {
+            FreeFrame* next;
+        };
+
+        struct FrameCache;
+
+        struct CacheRegistry {
+            std::mutex lock{};
+            std::vector<FrameCache*> caches{};
+            FrameAllocator::Statistics retired{};
+        };
+
+        // never destroyed, threads created before its first use (the timer thread) may exit after static teardown
+        CacheRegistry& getRegistry() {
+            static auto* registry = new CacheRegistry{};
+            return *registry;
+        }
+
+        struct FrameCache {
+            FreeFrame* freeLists[sizeClassCount]{};
+            std::size_t freeCounts[sizeClassCount]{};
+
+            // only written by the owner thread, read by getStatistics()
+            std::atomic<uint64_t> allocated{0};
+            std::atomic<uint64_t> recycled{0};
+            std::atomic<uint64_t> oversized{0};
+
+            FrameCache() {
+                auto& registry = getRegistry();
+                std::lock_guard lock{registry.lock};
+                registry.caches.push_back(this);
+            }
+
+            ~FrameCache();
+        };
+
+        enum class CacheState : uint8_t {
+            Uninitialized,
+            Alive,
+            Destroyed,
+        };
+
+        // trivially destructible, still readable after the cache itself is gone
+        thread_local CacheState cacheState{CacheState::Uninitialized};
+        thread_local FrameCache frameCache{};
+
+        FrameCache::~FrameCache() {
+            cacheState = CacheState::Destroyed;
+
+            for (auto& freeList: freeLists) {
+                while (freeList) {
+                    ::operator delete(std::exchange(freeList, freeList->next));
+                }
+            }
+
+            auto& registry = getRegistry();
+            std::lock_guard lock{registry.lock};
+            registry.retired.allocated += allocated.load(std::memory_order_relaxed);
+            registry.retired.recycled += recycled.load(std::memory_order_relaxed);
+            registry.retired.oversized += oversized.load(std::memory_order_relaxed);
+            std::erase(registry.caches, this);
+        }
+
+        FrameCache* getCache() {
+            if (cacheState == CacheState::Destroyed) {
+                return nullptr;
+            }
+
+            cacheState = CacheState::Alive;
+            return &frameCache;
+        }
+
+        void increase(std::atomic<uint64_t>& counter) {
+            counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+    }
+
+    void* FrameAllocator::allocate(const std::size_t size) {
+        auto* cache = getCache();
+        const auto sizeClass = (size - 1) / sizeClassGranularity;
+
+        if (cache) increase(cache->allocated);
+
+        if (sizeClass >= sizeClassCount) {
+            if (cache) increase(cache->oversized);
+            return ::operator new(size);
+        }
+
+        if (cache && cache->freeLists[sizeClass]) {
+            increase(cache->recycled);
+            cache->freeCounts[sizeClass]--;
+            return std::exchange(cache->freeLists[sizeClass], cache->freeLists[sizeClass]->next);
+        }
+
+        // round up, so the frame can serve any request of the same class later
+        return ::operator new((sizeClass + 1) * sizeClassGranularity);
+    }
+
+    void FrameAllocator::deallocate(void* ptr, const std::size_t size) noexcept {
+        auto* cache = getCache();
+        const auto sizeClass = (size - 1) / sizeClassGranularity;
+
+        if (!cache || sizeClass >= sizeClassCount || cache->freeCounts[sizeClass] >= maxCachedFrames) {
+            ::operator delete(ptr);
+            return;
+        }
+
+        // frames may be freed on another thread than they were allocated, they just join this thread's list
+        auto* frame = static_cast<FreeFrame*>(ptr);
+        frame->next = cache->freeLists[sizeClass];
+        cache->freeLists[sizeClass] = frame;
+        cache->freeCounts[sizeClass]++;
+    }
+
+    FrameAllocator::Statistics FrameAllocator::getStatistics() {
+        auto& registry = getRegistry();
+        std::lock_guard lock{registry.lock};
+
+        auto result = registry.retired;
+        for (const auto* cache: registry.caches) {
+            result.allocated += cache->allocated.load(std::memory_order_relaxed);
+            result.recycled += cache->recycled.load(std::memory_order_relaxed);
+            result.oversized += cache->oversized.load(std::memory_order_relaxed);
+        }
+
+        return result;
+    }
+}
@@ -0,0 +1,45 @@
+//
+// Created by qingy on 2024/8/12.
+//
+
+#pragma once
+#ifndef ZEPO_FRAMEALLOCATOR_HPP
+#define ZEPO_FRAMEALLOCATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace zepo::internal {
+    // allocator for coroutine frames, small frames are recycled through thread-local free lists
+    // grouped by size class, everything else goes to the global operator new
+    class FrameAllocator {
+    public:
+        struct Statistics {
+            // frames requested in total
+            uint64_t allocated{0};
+            // frames served from a free list
+            uint64_t recycled{0};
+            // frames too large for any size class
+            uint64_t oversized{0};
+        };
+
+        static void* allocate(std::size_t size);
+
+        static void deallocate(void* ptr, std::size_t size) noexcept;
+
+        static Statistics getStatistics();
+    };
+
+    // give a promise type pooled frames
+    struct PooledFrame {
+        static void* operator new(const std::size_t size) {
+            return FrameAllocator::allocate(size);
+        }
+
+        static void operator delete(void* ptr, const std::size_t size) noexcept {
+            FrameAllocator::deallocate(ptr, size);
+        }
+    };
+}
+
+#endif //ZEPO_FRAMEALLOCATOR_HPP
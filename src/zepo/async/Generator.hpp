@@ -6,10 +6,15 @@
 #ifndef ZEPO_GENERATOR_HPP
 #define ZEPO_GENERATOR_HPP
 #include <coroutine>
+#include <cstddef>
 #include <exception>
+#include <iterator>
 #include <memory>
 #include <stdexcept>
 #include <type_traits>
+#include <utility>
+
+#include "zepo/async/FrameAllocator.hpp"
 
 namespace zepo {
     template<typename YieldType>
@@ -17,7 +22,9 @@ namespace zepo {
 
     namespace internal {
         template<typename YieldType>
-        struct GeneratorPromise {
+        struct GeneratorPromise : PooledFrame {
+            using ValueType = std::remove_reference_t<YieldType>;
+
             enum Status {
                 Running = 0,
                 Completed,
@@ -25,28 +32,40 @@ namespace zepo {
             };
 
         private:
-            YieldType* yieldValue_{nullptr};
+            // points into the suspended coroutine frame, so yielding never allocates
+            ValueType* yieldValue_{nullptr};
             std::exception_ptr exception_{};
             Status status_{Running};
 
         public:
+            // `co_yield` of a const lvalue, the copy lives in the awaiter until the coroutine resumes
+            struct CopyAwaiter {
+                std::remove_cv_t<ValueType> value;
+                ValueType** slot;
+
+                [[nodiscard]] bool await_ready() const noexcept {
+                    return false;
+                }
+
+                void await_suspend(std::coroutine_handle<>) noexcept {
+                    *slot = std::addressof(value);
+                }
+
+                void await_resume() const noexcept {
+                }
+            };
+
             GeneratorPromise() = default;
 
             GeneratorPromise(const GeneratorPromise&) = delete;
 
             GeneratorPromise(GeneratorPromise&&) = delete;
 
-            ~GeneratorPromise() {
-                if constexpr (!std::is_void_v<YieldType>) {
-                    delete yieldValue_;
-                }
-            }
-
             [[nodiscard]] Status getStatus() const {
                 return status_;
             }
 
-            [[nodiscard]] YieldType* getValue() const {
+            [[nodiscard]] ValueType* getValue() const {
                 return yieldValue_;
             }
 
@@ -64,21 +83,28 @@ namespace zepo {
                 return std::suspend_always{};
             }
 
-            auto yield_value(YieldType v) {
-                delete yieldValue_;
-                yieldValue_ = new YieldType{v};
+            // temporaries and locals outlive the suspension, keep their address only
+            auto yield_value(ValueType& v) noexcept {
+                yieldValue_ = std::addressof(v);
+                return std::suspend_always{};
+            }
 
+            auto yield_value(ValueType&& v) noexcept {
+                yieldValue_ = std::addressof(v);
                 return std::suspend_always{};
             }
 
+            auto yield_value(const ValueType& v) requires(!std::is_const_v<ValueType>) {
+                return CopyAwaiter{v, &yieldValue_};
+            }
+
             void return_void() {
-                delete yieldValue_;
                 yieldValue_ = nullptr;
-
                 status_ = Completed;
             }
 
             void unhandled_exception() {
+                yieldValue_ = nullptr;
                 exception_ = std::current_exception();
                 status_ = Exception;
             }
@@ -89,23 +115,63 @@ namespace zepo {
     struct Generator {
         using PromiseType = internal::GeneratorPromise<YieldType>;
         using HandleType = std::coroutine_handle<PromiseType>;
+        using ValueType = typename PromiseType::ValueType;
 
     private:
         HandleType handle_{};
 
-        void rethrowExceptionIfNeed() {
+        void rethrowExceptionIfNeed() const {
             if (auto& promise = handle_.promise(); promise.getStatus() == PromiseType::Exception) {
                 std::rethrow_exception(promise.getException());
             }
         }
 
     public:
+        // single pass, `*iter` refers to the yielded object until the next increment
+        class Iterator {
+            Generator* generator_{nullptr};
+
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using difference_type = std::ptrdiff_t;
+            using value_type = std::remove_cv_t<ValueType>;
+            using reference = ValueType&;
+            using pointer = ValueType*;
+
+            Iterator() = default;
+
+            explicit Iterator(Generator* generator) : generator_{generator} {
+            }
+
+            reference operator*() const {
+                return generator_->getCurrent();
+            }
+
+            pointer operator->() const {
+                return std::addressof(generator_->getCurrent());
+            }
+
+            Iterator& operator++() {
+                generator_->moveNext();
+                return *this;
+            }
+
+            void operator++(int) {
+                ++*this;
+            }
+
+            bool operator==(std::default_sentinel_t) const {
+                return generator_->handle_.promise().getStatus() == PromiseType::Completed;
+            }
+        };
+
         explicit Generator(HandleType handle) : handle_{handle} {
         }
 
         Generator(const Generator&) = delete;
 
-        Generator(Generator&&) = default;
+        Generator(Generator&& other) noexcept : handle_{std::exchange(other.handle_, nullptr)} {
+        }
 
         ~Generator() {
             if (handle_) {
@@ -113,25 +179,35 @@ namespace zepo {
             }
         }
 
+        // an exception thrown by the coroutine is rethrown here
         bool moveNext() {
             auto& promise = handle_.promise();
-            if (promise.getStatus() == PromiseType::Completed) {
+            if (promise.getStatus() != PromiseType::Running) {
                 return false;
             }
 
             handle_.resume();
+            rethrowExceptionIfNeed();
             return promise.getStatus() != PromiseType::Completed;
         }
 
-        YieldType& getCurrent() {
-            rethrowExceptionIfNeed();
+        ValueType& getCurrent() {
             return *handle_.promise().getValue();
         }
 
-        [[nodiscard]] const YieldType& getCurrent() const {
-            rethrowExceptionIfNeed();
+        [[nodiscard]] const ValueType& getCurrent() const {
             return *handle_.promise().getValue();
         }
+
+        // `for (auto& value: generator)`, starts the coroutine
+        Iterator begin() {
+            moveNext();
+            return Iterator{this};
+        }
+
+        std::default_sentinel_t end() const noexcept {
+            return {};
+        }
     };
 
     namespace internal {
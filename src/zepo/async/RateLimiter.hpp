@@ -0,0 +1,87 @@
+//
+// Created by qingy on 2024/8/14.
+//
+
+#pragma once
+#ifndef ZEPO_RATELIMITER_HPP
+#define ZEPO_RATELIMITER_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "zepo/async/Task.hpp"
+#include "zepo/async/TaskUtils.hpp"
+
+namespace zepo
+{
+    // token bucket of `burst` permits refilled at `permitsPerSecond`, kept as a single "bucket is full again"
+    // timestamp (GCRA), so taking a permit is one compare-and-swap and never takes a lock
+    class RateLimiter
+    {
+        using Clock = std::chrono::steady_clock;
+
+        int64_t interval_;
+        int64_t tolerance_;
+        std::atomic<int64_t> theoreticalArrival_{0};
+
+        static int64_t now() noexcept
+        {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+        }
+
+    public:
+        explicit RateLimiter(const double permitsPerSecond, const int64_t burst = 1)
+            : interval_{std::max<int64_t>(1, static_cast<int64_t>(1e9 / permitsPerSecond))},
+              tolerance_{interval_ * (std::max<int64_t>(burst, 1) - 1)}
+        {
+        }
+
+        RateLimiter(const RateLimiter&) = delete;
+
+        RateLimiter(RateLimiter&&) = delete;
+
+        // takes a permit if one is available right now
+        [[nodiscard]] bool tryAcquire() noexcept
+        {
+            const auto current = now();
+            auto arrival = theoreticalArrival_.load(std::memory_order_relaxed);
+            do
+            {
+                const auto base = std::max(arrival, current);
+                if (base - tolerance_ > current) return false;
+
+                if (theoreticalArrival_.compare_exchange_weak(arrival, base + interval_, std::memory_order_relaxed))
+                {
+                    return true;
+                }
+            } while (true);
+        }
+
+        // reserves the next permit, returns how long to wait before it may be used
+        [[nodiscard]] std::chrono::nanoseconds reserve() noexcept
+        {
+            const auto current = now();
+            auto arrival = theoreticalArrival_.load(std::memory_order_relaxed);
+            int64_t base;
+            do
+            {
+                base = std::max(arrival, current);
+            } while (!theoreticalArrival_.compare_exchange_weak(arrival, base + interval_, std::memory_order_relaxed));
+
+            return std::chrono::nanoseconds{std::max<int64_t>(0, base - tolerance_ - current)};
+        }
+
+        // `co_await limiter.acquire()`, permits are handed out in reservation order
+        Task<> acquire()
+        {
+            if (const auto wait = reserve(); wait.count() > 0)
+            {
+                co_await TaskUtils::delay(wait);
+            }
+        }
+    };
+}
+
+#endif //ZEPO_RATELIMITER_HPP
@@ -6,176 +6,301 @@
 #ifndef ZEPO_TASK_HPP
 #define ZEPO_TASK_HPP
 
+#include <atomic>
 #include <coroutine>
-#include <memory>
-#include <thread>
-#include <condition_variable>
-#include <functional>
+#include <cstdint>
+#include <exception>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "zepo/async/Executor.hpp"
+#include "zepo/async/FrameAllocator.hpp"
 
 namespace zepo {
     template<typename ReturnType = void>
     class Task;
 
     namespace internal {
-        struct BasePromise {
-            BasePromise() = default;
+        // completion state shared by a Task and whatever produces its result,
+        // lives inside the coroutine frame or, for TaskCompletionSource, on its own.
+        // coroutines start lazily, the first awaiter transfers into them and their completion transfers back,
+        // so chains of synchronously completing awaits don't nest on the native stack
+        class TaskStateBase {
+        public:
+            enum Status {
+                Pending = 0,
+                Completed,
+                Exception,
+            };
 
-            BasePromise(const BasePromise&) = delete;
+        private:
+            // pending -> continuation registered -> completed, `WaitingFlag` is set by synchronous waiters
+            static constexpr uint32_t ContinuationFlag = 1;
+            static constexpr uint32_t CompletedFlag = 2;
+            static constexpr uint32_t WaitingFlag = 4;
+            static constexpr uint32_t StartedFlag = 8;
+            static constexpr uint32_t ResultSetFlag = 16;
+
+            std::atomic<uint32_t> flags_{0};
+            std::atomic<uint32_t> references_{1};
+            std::coroutine_handle<> continuation_{};
+            Executor* continuationExecutor_{nullptr};
+
+        protected:
+            Status status_{Pending};
+
+            // the not yet started coroutine, empty for states completed from outside
+            std::coroutine_handle<> coroutine_{};
+
+            virtual void destroy() = 0;
+
+            // taken before the result is written, a second set throws instead of overwriting a result
+            // an awaiter may already be reading
+            void claimResult() {
+                if (flags_.fetch_or(ResultSetFlag, std::memory_order_acq_rel) & ResultSetFlag) {
+                    throw std::runtime_error("Cannot set result twice");
+                }
+            }
 
-            BasePromise(BasePromise&&) = delete;
+        public:
+            TaskStateBase() = default;
 
-            auto initial_suspend() noexcept {
-                return std::suspend_never{};
+            TaskStateBase(const TaskStateBase&) = delete;
+
+            TaskStateBase(TaskStateBase&&) = delete;
+
+            virtual ~TaskStateBase() = default;
+
+            void addReference() noexcept {
+                references_.fetch_add(1, std::memory_order_relaxed);
             }
 
-            auto final_suspend() noexcept {
-                return std::suspend_always{};
+            void release() noexcept {
+                if (references_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    destroy();
+                }
             }
-        };
 
-        template<typename ReturnType>
-        struct UnsafeAwaiter {
-            using ContinueAction = std::function<void(UnsafeAwaiter*)>;
+            [[nodiscard]] bool isCompleted() const noexcept {
+                return flags_.load(std::memory_order_acquire) & CompletedFlag;
+            }
 
-            enum Status {
-                Pending = 0,
-                Completed,
-                Exception,
-            };
+            [[nodiscard]] Status getStatus() const noexcept {
+                return isCompleted() ? status_ : Pending;
+            }
 
-        private:
-            ReturnType* returnValue_{nullptr};
-            std::exception_ptr exception_{};
+            // returns the coroutine if the caller is the one to start it, it holds a reference until completed
+            std::coroutine_handle<> claimStart() noexcept {
+                if (!coroutine_ || (flags_.load(std::memory_order_acquire) & StartedFlag)) {
+                    return {};
+                }
 
-            Status completed_{Pending};
-            ContinueAction continueAction_{};
+                if (flags_.fetch_or(StartedFlag, std::memory_order_acq_rel) & StartedFlag) {
+                    return {};
+                }
 
-            std::mutex mutex_{};
-            std::condition_variable condVar_{};
+                addReference();
+                return coroutine_;
+            }
 
-        public:
-            explicit UnsafeAwaiter() = default;
+            // returns false when already completed, the caller should go on without suspending
+            bool continueWith(const std::coroutine_handle<> handle) {
+                auto flags = flags_.load(std::memory_order_acquire);
+                if (flags & ContinuationFlag) {
+                    throw std::runtime_error("Task can await only once");
+                }
 
-            UnsafeAwaiter(const UnsafeAwaiter&) noexcept = delete;
+                continuation_ = handle;
+                continuationExecutor_ = Executor::getCurrent();
+                do {
+                    if (flags & CompletedFlag) {
+                        return false;
+                    }
 
-            UnsafeAwaiter(UnsafeAwaiter&&) noexcept = delete;
+                    if (flags & ContinuationFlag) {
+                        throw std::runtime_error("Task can await only once");
+                    }
+                } while (!flags_.compare_exchange_weak(flags, flags | ContinuationFlag,
+                                                       std::memory_order_acq_rel, std::memory_order_acquire));
 
-            ~UnsafeAwaiter() {
-                if constexpr (!std::is_void_v<ReturnType>) {
-                    delete returnValue_;
-                }
+                return true;
             }
 
-            void setResult(ReturnType* value) {
-                if (completed_) {
-                    throw std::runtime_error("Cannot set result twice");
-                } {
-                    std::unique_lock lock{mutex_};
-                    completed_ = Completed;
-                    returnValue_ = value;
+            // publish the stored result and wake synchronous waiters, returns the continuation to transfer to
+            [[nodiscard]] std::coroutine_handle<> complete() noexcept {
+                if (status_ == Pending) {
+                    status_ = Completed;
                 }
 
-                if (continueAction_) {
-                    continueAction_(this);
+                const auto flags = flags_.fetch_or(CompletedFlag, std::memory_order_acq_rel);
+                if (flags & CompletedFlag) {
+                    // `claimResult` already let only one producer through, a second completion is a bug
+                    std::terminate();
                 }
 
-                condVar_.notify_all();
+                if (flags & WaitingFlag) {
+                    flags_.notify_all();
+                }
+
+                if (flags & ContinuationFlag) {
+                    // resume on the executor the awaiter ran on, not on whichever thread completed this
+                    if (continuationExecutor_ != nullptr && continuationExecutor_ != Executor::getCurrent()) {
+                        continuationExecutor_->put([continuation = continuation_] { continuation.resume(); });
+                        return std::noop_coroutine();
+                    }
+
+                    return continuation_;
+                }
+
+                return std::noop_coroutine();
             }
 
-            void setException(const std::exception_ptr& exceptionPtr) {
-                if (completed_) {
-                    throw std::runtime_error("Cannot set result twice");
-                } {
-                    std::unique_lock lock{mutex_};
-                    completed_ = Exception;
-                    exception_ = exceptionPtr;
+            // runs a lazy coroutine inline, then blocks until completed
+            void wait() {
+                if (const auto coroutine = claimStart()) {
+                    coroutine.resume();
                 }
 
-                if (continueAction_) {
-                    continueAction_(this);
+                auto flags = flags_.fetch_or(WaitingFlag, std::memory_order_acq_rel);
+                while (!(flags & CompletedFlag)) {
+                    flags_.wait(flags, std::memory_order_acquire);
+                    flags = flags_.load(std::memory_order_acquire);
                 }
+            }
+        };
+
+        template<typename ReturnType>
+        class TaskState : public TaskStateBase {
+            // stored inline, no allocation for the result itself
+            std::variant<std::monostate, ReturnType, std::exception_ptr> result_{};
+
+        public:
+            template<typename... Args>
+            void setResult(Args&&... args) {
+                claimResult();
+                result_.template emplace<1>(std::forward<Args>(args)...);
+                status_ = Completed;
+            }
+
+            void setException(const std::exception_ptr& exceptionPtr) {
+                claimResult();
+                result_.template emplace<2>(exceptionPtr);
+                status_ = Exception;
+            }
+
+            [[nodiscard]] ReturnType& getResult() noexcept {
+                return *std::get_if<1>(&result_);
+            }
+
+            [[nodiscard]] std::exception_ptr getException() const noexcept {
+                return *std::get_if<2>(&result_);
+            }
+        };
+
+        template<>
+        class TaskState<void> : public TaskStateBase {
+            std::exception_ptr exception_{};
 
-                condVar_.notify_all();
+        public:
+            void setResult() {
+                claimResult();
+                status_ = Completed;
             }
 
-            [[nodiscard]] ReturnType* getResult() const {
-                return returnValue_;
+            void setException(const std::exception_ptr& exceptionPtr) {
+                claimResult();
+                exception_ = exceptionPtr;
+                status_ = Exception;
             }
 
-            [[nodiscard]] std::exception_ptr getException() const {
+            [[nodiscard]] std::exception_ptr getException() const noexcept {
                 return exception_;
             }
+        };
 
-            [[nodiscard]] Status getStatus() const noexcept {
-                return completed_;
+        // state without a coroutine, used by TaskCompletionSource
+        template<typename ReturnType>
+        class DetachedTaskState final : public TaskState<ReturnType> {
+        protected:
+            void destroy() override {
+                delete this;
             }
+        };
 
-            void continueWith(const ContinueAction& action) {
-                std::unique_lock lock{mutex_};
+        struct FinalAwaiter {
+            [[nodiscard]] bool await_ready() const noexcept {
+                return false;
+            }
 
-                if (completed_) {
-                    action(this);
-                    return;
-                }
+            template<typename PromiseType>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<PromiseType> handle) noexcept {
+                auto& promise = handle.promise();
+                const auto continuation = promise.complete();
+
+                // drop the reference of the running coroutine, the frame goes away with the last Task
+                promise.release();
+                return continuation;
+            }
 
-                continueAction_ = action;
+            void await_resume() const noexcept {
             }
+        };
 
-            void continueWith(ContinueAction&& action) {
-                std::unique_lock lock{mutex_};
+        struct BasePromise : PooledFrame {
+            BasePromise() = default;
 
-                if (completed_) {
-                    action(this);
-                    return;
-                }
-                continueAction_ = action;
+            BasePromise(const BasePromise&) = delete;
+
+            BasePromise(BasePromise&&) = delete;
+
+            auto initial_suspend() noexcept {
+                return std::suspend_always{};
             }
 
-            void wait() {
-                std::unique_lock lock{mutex_};
-                condVar_.wait(lock, [this] { return completed_; });
+            auto final_suspend() noexcept {
+                return FinalAwaiter{};
             }
         };
 
         template<typename ReturnType>
-        struct Promise : BasePromise {
+        struct Promise : BasePromise, TaskState<ReturnType> {
             using HandleType = std::coroutine_handle<Promise>;
-            using AwaiterType = UnsafeAwaiter<ReturnType>;
-            std::shared_ptr<AwaiterType> awaiter_{nullptr};
 
             Task<ReturnType> get_return_object();
 
-            void return_value(ReturnType value) noexcept {
-                if (awaiter_) {
-                    awaiter_->setResult(new ReturnType{std::move(value)});
-                }
+            void return_value(ReturnType value) {
+                this->setResult(std::move(value));
             }
 
-            void unhandled_exception() {
-                if (awaiter_) {
-                    awaiter_->setException(std::current_exception());
-                }
+            void unhandled_exception() noexcept {
+                this->setException(std::current_exception());
+            }
+
+        protected:
+            void destroy() override {
+                HandleType::from_promise(*this).destroy();
             }
         };
 
         template<>
-        struct Promise<void> : BasePromise {
+        struct Promise<void> : BasePromise, TaskState<void> {
             using HandleType = std::coroutine_handle<Promise>;
-            using AwaiterType = UnsafeAwaiter<void>;
-            std::shared_ptr<AwaiterType> awaiter_{nullptr};
 
             Task<> get_return_object();
 
-            void return_void() const noexcept {
-                if (awaiter_) {
-                    awaiter_->setResult(nullptr);
-                }
+            void return_void() noexcept {
+                setResult();
             }
 
-            void unhandled_exception() const {
-                if (awaiter_) {
-                    awaiter_->setException(std::current_exception());
-                }
+            void unhandled_exception() noexcept {
+                setException(std::current_exception());
+            }
+
+        protected:
+            void destroy() override {
+                HandleType::from_promise(*this).destroy();
             }
         };
     }
@@ -184,54 +309,113 @@ namespace zepo {
     template<typename ReturnType>
     class Task {
     public:
-        using AwaiterType = internal::UnsafeAwaiter<ReturnType>;
+        using StateType = internal::TaskState<ReturnType>;
         using PromiseType = internal::Promise<ReturnType>;
 
     private:
-        std::shared_ptr<AwaiterType> awaiter_{};
-        bool awaited_{false};
+        // `void` cannot be referenced, keep a placeholder to spell the signatures
+        using ResultType = std::conditional_t<std::is_void_v<ReturnType>, std::monostate, ReturnType>;
+
+        template<typename ResumeType>
+        struct Awaiter {
+            StateType* state;
+
+            [[nodiscard]] bool await_ready() const noexcept {
+                return state->isCompleted();
+            }
+
+            std::coroutine_handle<> await_suspend(const std::coroutine_handle<> handle) const {
+                if (const auto coroutine = state->claimStart()) {
+                    state->continueWith(handle);
+                    return coroutine;
+                }
+
+                if (state->continueWith(handle)) {
+                    return std::noop_coroutine();
+                }
+
+                return handle;
+            }
+
+            auto await_resume() const -> std::conditional_t<std::is_void_v<ReturnType>, void, ResumeType> {
+                if (state->getStatus() == StateType::Exception) {
+                    std::rethrow_exception(state->getException());
+                }
+
+                if constexpr (std::is_void_v<ReturnType>) {
+                    return;
+                } else if constexpr (std::is_reference_v<ResumeType>) {
+                    return state->getResult();
+                } else {
+                    return std::move(state->getResult());
+                }
+            }
+        };
+
+        StateType* state_{nullptr};
 
     public:
-        explicit Task(std::shared_ptr<AwaiterType> awaiter)
-            : awaiter_{std::move(awaiter)} {
+        // takes a new reference of `state`
+        explicit Task(StateType* state)
+            : state_{state} {
+            state_->addReference();
         }
 
-        Task(const Task&) = default;
-
-        Task(Task&&) = default;
+        Task(const Task& other)
+            : state_{other.state_} {
+            if (state_) state_->addReference();
+        }
 
-        [[nodiscard]] bool await_ready() const {
-            return awaiter_->getStatus();
+        Task(Task&& other) noexcept
+            : state_{std::exchange(other.state_, nullptr)} {
         }
 
-        void await_suspend(std::coroutine_handle<> handle) {
-            if (awaited_) {
-                throw std::runtime_error("Task can await only once");
+        Task& operator=(const Task& other) {
+            if (this != &other) {
+                Task copied{other};
+                std::swap(state_, copied.state_);
             }
 
-            awaited_ = true;
-            awaiter_->continueWith([handle](AwaiterType*) { handle.resume(); });
+            return *this;
         }
 
-        ReturnType await_resume() const {
-            if (awaiter_->getStatus() == AwaiterType::Exception) {
-                std::rethrow_exception(awaiter_->getException());
-            }
+        Task& operator=(Task&& other) noexcept {
+            std::swap(state_, other.state_);
+            return *this;
+        }
+
+        ~Task() {
+            if (state_) state_->release();
+        }
+
+        // `co_await task` reads the result in place, `co_await std::move(task)` or awaiting a temporary moves it out
+        auto operator co_await() const & noexcept {
+            return Awaiter<const ResultType&>{state_};
+        }
+
+        auto operator co_await() && noexcept {
+            return Awaiter<ReturnType>{state_};
+        }
 
-            if constexpr (!std::is_void_v<ReturnType>) {
-                return *awaiter_->getResult();
-            } else {
-                return;
+        // run the coroutine without awaiting it, for tasks nobody awaits
+        void start() const {
+            if (const auto coroutine = state_->claimStart()) {
+                coroutine.resume();
             }
         }
 
         void wait() {
-            awaiter_->wait();
+            state_->wait();
+        }
+
+        decltype(auto) getValue() & {
+            wait();
+            return Awaiter<const ResultType&>{state_}.await_resume();
         }
 
-        ReturnType getValue() {
+        ReturnType getValue() && {
             wait();
-            return await_resume();
+            return Awaiter<ReturnType>{state_}.await_resume();
         }
     };
 
@@ -239,21 +423,20 @@ namespace zepo {
     namespace internal {
         template<typename ReturnType>
         Task<ReturnType> Promise<ReturnType>::get_return_object() {
-            if (awaiter_) {
-                throw std::runtime_error("Failed to construct Task twice");
-            }
+            this->coroutine_ = HandleType::from_promise(*this);
 
-            awaiter_ = std::make_shared<AwaiterType>();
-            return Task<ReturnType>{awaiter_};
+            // the initial reference belongs to the Task, the running coroutine takes its own once started
+            Task<ReturnType> task{this};
+            this->release();
+            return task;
         }
 
         inline Task<> Promise<void>::get_return_object() {
-            if (awaiter_) {
-                throw std::runtime_error("Failed to construct Task twice");
-            }
+            coroutine_ = HandleType::from_promise(*this);
 
-            awaiter_ = std::make_shared<AwaiterType>();
-            return Task<>{awaiter_};
+            Task<> task{this};
+            release();
+            return task;
         }
     }
 } // zepo
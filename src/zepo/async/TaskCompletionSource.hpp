@@ -6,7 +6,7 @@
 #ifndef ZEPO_TASKCOMPLETIONSOURCE_HPP
 #define ZEPO_TASKCOMPLETIONSOURCE_HPP
 
-#include <memory>
+#include <exception>
 #include "zepo/async/Task.hpp"
 
 namespace zepo
@@ -15,34 +15,43 @@ namespace zepo
     class TaskCompletionSource
     {
         using TaskType = Task<ReturnType>;
-        using AwaiterType = typename TaskType::AwaiterType;
+        using StateType = internal::DetachedTaskState<ReturnType>;
 
-        std::shared_ptr<AwaiterType> awaiter_{std::make_shared<AwaiterType>()};
-        std::unique_ptr<TaskType> task_;
+        StateType* state_{new StateType{}};
 
     public:
-        explicit TaskCompletionSource()
-            : task_{std::make_unique<TaskType>(awaiter_)}
-        {
-        }
+        explicit TaskCompletionSource() = default;
 
         TaskCompletionSource(const TaskCompletionSource&) = delete;
 
         TaskCompletionSource(TaskCompletionSource&& other) noexcept = delete;
 
-        [[nodiscard]] const TaskType& getTask() const
+        ~TaskCompletionSource()
+        {
+            state_->release();
+        }
+
+        [[nodiscard]] TaskType getTask() const
         {
-            return *task_;
+            return TaskType{state_};
         }
 
         void setResult(const ReturnType& val)
         {
-            awaiter_->setResult(new ReturnType{val});
+            state_->setResult(val);
+            state_->complete().resume();
         }
 
         void setResult(ReturnType&& val)
         {
-            awaiter_->setResult(new ReturnType{std::move(val)});
+            state_->setResult(std::move(val));
+            state_->complete().resume();
+        }
+
+        void setException(const std::exception_ptr& exceptionPtr)
+        {
+            state_->setException(exceptionPtr);
+            state_->complete().resume();
         }
     };
 
@@ -50,29 +59,37 @@ namespace zepo
     class TaskCompletionSource<void>
     {
         using TaskType = Task<>;
-        using AwaiterType = TaskType::AwaiterType;
+        using StateType = internal::DetachedTaskState<void>;
 
-        std::shared_ptr<AwaiterType> awaiter_{std::make_shared<AwaiterType>()};
-        std::unique_ptr<TaskType> task_;
+        StateType* state_{new StateType{}};
 
     public:
-        explicit TaskCompletionSource()
-            : task_{std::make_unique<TaskType>(awaiter_)}
-        {
-        }
+        explicit TaskCompletionSource() = default;
 
         TaskCompletionSource(const TaskCompletionSource&) = delete;
 
         TaskCompletionSource(TaskCompletionSource&& other) noexcept = delete;
 
-        [[nodiscard]] const TaskType& getTask() const
+        ~TaskCompletionSource()
+        {
+            state_->release();
+        }
+
+        [[nodiscard]] TaskType getTask() const
         {
-            return *task_;
+            return TaskType{state_};
         }
 
         void setResult()
         {
-            awaiter_->setResult(nullptr);
+            state_->setResult();
+            state_->complete().resume();
+        }
+
+        void setException(const std::exception_ptr& exceptionPtr)
+        {
+            state_->setException(exceptionPtr);
+            state_->complete().resume();
         }
     };
 }
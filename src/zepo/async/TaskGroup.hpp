@@ -0,0 +1,192 @@
+//
+// Created by qingy on 2024/8/15.
+//
+
+#pragma once
+#ifndef ZEPO_TASKGROUP_HPP
+#define ZEPO_TASKGROUP_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "zepo/async/AsyncSemaphore.hpp"
+#include "zepo/async/CancellationToken.hpp"
+#include "zepo/async/Task.hpp"
+#include "zepo/async/TaskCompletionSource.hpp"
+
+namespace zepo
+{
+    namespace internal
+    {
+        struct TaskGroupState
+        {
+            // one reference belongs to `join`, so the group can't finish while children are still being spawned
+            std::atomic<size_t> outstanding{1};
+            std::atomic<size_t> running{0};
+            std::atomic<bool> failed{false};
+            std::exception_ptr exception{};
+
+            CancellationSource cancellation;
+            std::optional<AsyncSemaphore> limiter{};
+            TaskCompletionSource<> source{};
+
+            TaskGroupState(const size_t maxConcurrency, const CancellationToken& parent) : cancellation{parent}
+            {
+                if (maxConcurrency > 0)
+                {
+                    limiter.emplace(static_cast<int64_t>(maxConcurrency));
+                }
+            }
+
+            // the first failure is kept and cancels the siblings, later ones are mostly their cancellations
+            void fail(const std::exception_ptr& exceptionPtr)
+            {
+                if (failed.exchange(true, std::memory_order_acq_rel)) return;
+
+                exception = exceptionPtr;
+                cancellation.cancel();
+            }
+
+            void arrive()
+            {
+                if (outstanding.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+
+                if (failed.load(std::memory_order_acquire))
+                {
+                    source.setException(exception);
+                }
+                else
+                {
+                    source.setResult();
+                }
+            }
+        };
+    }
+
+    // structured concurrency: children spawned into the group run concurrently, at most `maxConcurrency`
+    // at a time (0 is unbounded), and `co_await group.join()` waits for all of them.
+    // the first child to throw cancels the group token and its exception is rethrown from `join`
+    class TaskGroup
+    {
+        std::shared_ptr<internal::TaskGroupState> state_;
+        bool joined_{false};
+
+        template <typename ValType>
+        static Task<> runChild(std::shared_ptr<internal::TaskGroupState> state, Task<ValType> task)
+        {
+            if (state->limiter)
+            {
+                co_await state->limiter->acquire();
+            }
+
+            state->running.fetch_add(1, std::memory_order_relaxed);
+            try
+            {
+                // children still queued behind the limit never start once the group is cancelled
+                state->cancellation.getToken().throwIfCancellationRequested();
+                co_await std::move(task);
+            }
+            catch (...)
+            {
+                state->fail(std::current_exception());
+            }
+            state->running.fetch_sub(1, std::memory_order_relaxed);
+
+            if (state->limiter)
+            {
+                state->limiter->release();
+            }
+
+            state->arrive();
+        }
+
+    public:
+        explicit TaskGroup(const size_t maxConcurrency = 0, const CancellationToken& parent = {})
+            : state_{std::make_shared<internal::TaskGroupState>(maxConcurrency, parent)}
+        {
+        }
+
+        TaskGroup(const TaskGroup&) = delete;
+
+        TaskGroup(TaskGroup&&) = delete;
+
+        // a group dropped without `join` cancels its children, they finish on their own
+        ~TaskGroup()
+        {
+            if (!joined_)
+            {
+                state_->cancellation.cancel();
+            }
+        }
+
+        // starts `task` now, or once a slot is free. children may spawn siblings until the group has finished
+        template <typename ValType>
+        void spawn(Task<ValType> task)
+        {
+            auto outstanding = state_->outstanding.load(std::memory_order_relaxed);
+            do
+            {
+                if (outstanding == 0)
+                {
+                    throw std::runtime_error("task group already finished");
+                }
+            } while (!state_->outstanding.compare_exchange_weak(outstanding, outstanding + 1,
+                                                                std::memory_order_acq_rel));
+
+            runChild(state_, std::move(task)).start();
+        }
+
+        // spawns `func(token)`, the token is cancelled when a sibling fails or the group is cancelled
+        template <typename Func>
+            requires std::is_invocable_v<Func, CancellationToken>
+        void spawn(Func&& func)
+        {
+            spawn(std::forward<Func>(func)(getToken()));
+        }
+
+        // completes when every child finished, rethrows the first failure
+        Task<> join()
+        {
+            if (joined_)
+            {
+                throw std::runtime_error("task group can join only once");
+            }
+
+            joined_ = true;
+            auto result = state_->source.getTask();
+            state_->arrive();
+            return result;
+        }
+
+        void cancel() const noexcept
+        {
+            state_->cancellation.cancel();
+        }
+
+        [[nodiscard]] CancellationToken getToken() const
+        {
+            return state_->cancellation.getToken();
+        }
+
+        // children spawned and not finished yet, including the ones waiting for a slot
+        [[nodiscard]] size_t getPendingCount() const noexcept
+        {
+            const auto outstanding = state_->outstanding.load(std::memory_order_relaxed);
+            return joined_ ? outstanding : outstanding - 1;
+        }
+
+        // children currently holding a slot
+        [[nodiscard]] size_t getRunningCount() const noexcept
+        {
+            return state_->running.load(std::memory_order_relaxed);
+        }
+    };
+}
+
+#endif //ZEPO_TASKGROUP_HPP
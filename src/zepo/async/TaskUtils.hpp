@@ -6,78 +6,398 @@
 #ifndef ZEPO_TASKUTILS_HPP
 #define ZEPO_TASKUTILS_HPP
 
+#include "zepo/async/CancellationToken.hpp"
 #include "zepo/async/Task.hpp"
 #include "zepo/async/TaskCompletionSource.hpp"
-#include <functional>
+#include "zepo/async/TimerWheel.hpp"
+#include <atomic>
 #include <chrono>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
 
-#include "ThreadPool.hpp"
+#include "WorkStealingPool.hpp"
 
 namespace zepo
 {
+    namespace internal
+    {
+        template <typename ValType>
+        struct WhenAllState;
+
+        // countdown shared by the observers of whenAll, the caller is resumed by whoever finishes it
+        template <typename ValType>
+        struct WhenAllStateBase
+        {
+            std::atomic<size_t> remaining;
+            std::atomic<bool> finished{false};
+            std::atomic<bool> failed{false};
+            std::exception_ptr exception{};
+            bool failFast;
+
+            WhenAllStateBase(size_t count, bool failFast) : remaining{count}, failFast{failFast}
+            {
+            }
+
+            void fail(const std::exception_ptr& exceptionPtr)
+            {
+                if (failed.exchange(true, std::memory_order_acq_rel)) return;
+                exception = exceptionPtr;
+
+                if (failFast && !finished.exchange(true, std::memory_order_acq_rel))
+                {
+                    static_cast<WhenAllState<ValType>*>(this)->source.setException(exception);
+                }
+            }
+
+            void arrive()
+            {
+                if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    finish();
+                }
+            }
+
+            void finish()
+            {
+                if (finished.exchange(true, std::memory_order_acq_rel)) return;
+
+                auto* self = static_cast<WhenAllState<ValType>*>(this);
+                if (failed.load(std::memory_order_acquire))
+                {
+                    self->source.setException(exception);
+                    return;
+                }
+
+                self->complete();
+            }
+        };
+
+        template <typename ValType>
+        struct WhenAllState : WhenAllStateBase<ValType>
+        {
+            using ResultType = std::vector<ValType>;
+
+            TaskCompletionSource<ResultType> source{};
+            std::vector<std::optional<ValType>> results;
+
+            WhenAllState(size_t count, bool failFast) : WhenAllStateBase<ValType>{count, failFast}, results(count)
+            {
+            }
+
+            void complete()
+            {
+                std::vector<ValType> values{};
+                values.reserve(results.size());
+                for (auto& result : results)
+                {
+                    values.push_back(std::move(*result));
+                }
+
+                source.setResult(std::move(values));
+            }
+        };
+
+        template <>
+        struct WhenAllState<void> : WhenAllStateBase<void>
+        {
+            using ResultType = void;
+
+            TaskCompletionSource<> source{};
+
+            WhenAllState(size_t count, bool failFast) : WhenAllStateBase{count, failFast}
+            {
+            }
+
+            void complete()
+            {
+                source.setResult();
+            }
+        };
+
+        template <typename ValType>
+        struct TimeoutState
+        {
+            std::atomic<bool> finished{false};
+            TaskCompletionSource<ValType> source{};
+        };
+
+        struct WhenAnyState
+        {
+            std::atomic<size_t> remaining;
+            std::atomic<bool> finished{false};
+            std::atomic<bool> failed{false};
+            std::exception_ptr exception{};
+            bool failFast;
+            TaskCompletionSource<size_t> source{};
+
+            WhenAnyState(size_t count, bool failFast) : remaining{count}, failFast{failFast}
+            {
+            }
+
+            void succeed(size_t index)
+            {
+                if (!finished.exchange(true, std::memory_order_acq_rel))
+                {
+                    source.setResult(index);
+                }
+            }
+
+            void fail(const std::exception_ptr& exceptionPtr)
+            {
+                if (!failed.exchange(true, std::memory_order_acq_rel))
+                {
+                    exception = exceptionPtr;
+                }
+
+                // rethrow the first exception once nothing can succeed anymore
+                if ((failFast || remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    && !finished.exchange(true, std::memory_order_acq_rel))
+                {
+                    source.setException(failFast ? exceptionPtr : exception);
+                }
+            }
+        };
+    }
+
     class TaskUtils
     {
     public:
+        // run blocking work on the blocking I/O pool, the awaiting coroutine resumes on its own executor.
+        // a job still queued when `cancellationToken` is cancelled is dropped and fails with OperationCancelledException
         template <typename ReturnType = void>
-        static Task<ReturnType> run(std::function<ReturnType()> func)
+        static Task<ReturnType> run(std::function<ReturnType()> func, CancellationToken cancellationToken = {})
+        {
+            return runOn<ReturnType>(WorkStealingPool::getBlockingPool(), std::move(func), std::move(cancellationToken));
+        }
+
+        template <typename ReturnType = void>
+        static Task<ReturnType> runOn(Executor& executor, std::function<ReturnType()> func,
+                                      CancellationToken cancellationToken = {})
         {
             auto taskCompletionSource{std::make_shared<TaskCompletionSource<ReturnType>>()};
 
-            ThreadPool::getDefaultPool().put([taskCompletionSource, func]
+            executor.put([taskCompletionSource, func = std::move(func),
+                    cancellationToken = std::move(cancellationToken)]
             {
-                if constexpr (std::is_void_v<ReturnType>)
+                try
                 {
-                    func();
-                    taskCompletionSource->setResult();
+                    cancellationToken.throwIfCancellationRequested();
+
+                    if constexpr (std::is_void_v<ReturnType>)
+                    {
+                        func();
+                        taskCompletionSource->setResult();
+                    }
+                    else
+                    {
+                        taskCompletionSource->setResult(func());
+                    }
                 }
-                else
+                catch (...)
                 {
-                    taskCompletionSource->setResult(func());
+                    taskCompletionSource->setException(std::current_exception());
                 }
             });
 
             return taskCompletionSource->getTask();
         }
 
-
+        // completes on the timer thread, no worker sleeps through the delay
         template <typename T1, typename T2>
         static Task<> delay(std::chrono::duration<T1, T2> duration)
         {
-            return run<void>([duration] { std::this_thread::sleep_for(duration); });
+            auto taskCompletionSource{std::make_shared<TaskCompletionSource<>>()};
+
+            TimerWheel::getDefault().schedule(std::chrono::duration_cast<TimerWheel::Clock::duration>(duration),
+                                              [taskCompletionSource] { taskCompletionSource->setResult(); });
+
+            return taskCompletionSource->getTask();
         }
 
+        // completes like `task`, or throws TimeoutException once `duration` elapsed first.
+        // `task` itself keeps running, cancel it through its CancellationToken to stop it
+        template <typename ValType, typename T1, typename T2>
+        static Task<ValType> withTimeout(Task<ValType> task, std::chrono::duration<T1, T2> duration)
+        {
+            const auto state = std::make_shared<internal::TimeoutState<ValType>>();
+            auto result = state->source.getTask();
+
+            const auto timer = TimerWheel::getDefault().schedule(
+                std::chrono::duration_cast<TimerWheel::Clock::duration>(duration), [state]
+                {
+                    if (!state->finished.exchange(true, std::memory_order_acq_rel))
+                    {
+                        state->source.setException(std::make_exception_ptr(TimeoutException{}));
+                    }
+                });
+
+            // the timer holds `state` until it fires or is cancelled, `observeTimeout` cancels it
+            observeTimeout(std::move(task), state, timer).start();
+            return result;
+        }
+
+        // wait for every task concurrently, results keep the order of the tasks.
+        // with `failFast` the first exception completes the returned task, otherwise it is thrown after all finished
         template <typename ValType, typename Iter>
-        static Task<std::vector<ValType>> whenAll(Iter begin, Iter end)
+        static Task<std::vector<ValType>> whenAll(Iter begin, Iter end, bool failFast = false)
+        {
+            return whenAllImpl<ValType>(std::vector<Task<ValType>>{begin, end}, false, failFast);
+        }
+
+        // same as above, but the results are moved out of `tasks`
+        template <typename ValType>
+        static Task<std::vector<ValType>> whenAll(std::vector<Task<ValType>> tasks, bool failFast = false)
+        {
+            return whenAllImpl<ValType>(std::move(tasks), true, failFast);
+        }
+
+        template <typename Iter>
+        static Task<> whenAll(Iter begin, Iter end, bool failFast = false)
         {
-            std::vector<ValType> result{};
-            for (auto& it = begin; it != end; ++it)
+            return whenAllImpl<void>(std::vector<Task<>>{begin, end}, false, failFast);
+        }
+
+        inline static Task<> whenAll(std::vector<Task<>>& tasks, bool failFast = false)
+        {
+            return whenAllImpl<void>(std::vector<Task<>>{tasks}, false, failFast);
+        }
+
+        // completes with the index of the first task that succeeded, failures only count once every task failed.
+        // with `failFast` the first task to finish decides, even if it failed
+        template <typename ValType>
+        static Task<size_t> whenAny(std::vector<Task<ValType>> tasks, bool failFast = false)
+        {
+            if (tasks.empty())
             {
-                result.emplace_back(co_await *it);
+                throw std::runtime_error("whenAny requires at least one task");
             }
 
-            co_return result;
+            const auto state = std::make_shared<internal::WhenAnyState>(tasks.size(), failFast);
+            auto result = state->source.getTask();
+
+            for (size_t i = 0; i < tasks.size(); ++i)
+            {
+                observeAny(std::move(tasks[i]), i, state).start();
+            }
+
+            return result;
+        }
+
+        template <typename Iter>
+        static Task<size_t> whenAny(Iter begin, Iter end, bool failFast = false)
+        {
+            using ValType = decltype(std::declval<std::remove_cvref_t<decltype(*begin)>>().getValue());
+            return whenAny(std::vector<Task<std::remove_cvref_t<ValType>>>{begin, end}, failFast);
         }
 
+    private:
         template <typename ValType>
-        static Task<std::vector<ValType>> whenAll(std::vector<Task<ValType>> tasks)
+        static Task<typename internal::WhenAllState<ValType>::ResultType> whenAllImpl(
+            std::vector<Task<ValType>> tasks, bool moveResults, bool failFast)
+        {
+            using StateType = internal::WhenAllState<ValType>;
+
+            const auto state = std::make_shared<StateType>(tasks.size(), failFast);
+            auto result = state->source.getTask();
+
+            if (tasks.empty())
+            {
+                state->finish();
+                return result;
+            }
+
+            for (size_t i = 0; i < tasks.size(); ++i)
+            {
+                observeAll(std::move(tasks[i]), i, moveResults, state).start();
+            }
+
+            return result;
+        }
+
+        // detached observer of a single child, started right away and owns a reference of the shared state
+        template <typename ValType, typename StateType>
+        static Task<> observeAll(Task<ValType> task, size_t index, bool moveResult, std::shared_ptr<StateType> state)
         {
-            // co_return + co_await to keep the parameter `tasks` alive
-            co_return co_await whenAll<ValType>(tasks.begin(), tasks.end());
+            try
+            {
+                if constexpr (std::is_void_v<ValType>)
+                {
+                    co_await task;
+                }
+                else if (moveResult)
+                {
+                    state->results[index].emplace(co_await std::move(task));
+                }
+                else
+                {
+                    state->results[index].emplace(co_await task);
+                }
+            }
+            catch (...)
+            {
+                state->fail(std::current_exception());
+            }
+
+            state->arrive();
         }
 
-        template <typename Iter>
-        static Task<> whenAll(Iter begin, Iter end)
+        template <typename ValType>
+        static Task<> observeTimeout(Task<ValType> task, std::shared_ptr<internal::TimeoutState<ValType>> state,
+                                     TimerWheel::Handle timer)
         {
-            for (; begin != end; ++begin)
+            std::exception_ptr exception{};
+            try
+            {
+                if constexpr (std::is_void_v<ValType>)
+                {
+                    co_await std::move(task);
+                    timer.cancel();
+                    if (!state->finished.exchange(true, std::memory_order_acq_rel))
+                    {
+                        state->source.setResult();
+                    }
+                }
+                else
+                {
+                    auto value = co_await std::move(task);
+                    timer.cancel();
+                    if (!state->finished.exchange(true, std::memory_order_acq_rel))
+                    {
+                        state->source.setResult(std::move(value));
+                    }
+                }
+
+                co_return;
+            }
+            catch (...)
             {
-                co_await *begin;
+                exception = std::current_exception();
+            }
+
+            timer.cancel();
+            if (!state->finished.exchange(true, std::memory_order_acq_rel))
+            {
+                state->source.setException(exception);
             }
         }
 
-        inline static Task<> whenAll(std::vector<Task<>>& tasks)
+        template <typename ValType>
+        static Task<> observeAny(Task<ValType> task, size_t index, std::shared_ptr<internal::WhenAnyState> state)
         {
-            // co_await to keep the parameter `tasks` alive
-            co_await whenAll(tasks.begin(), tasks.end());
+            try
+            {
+                co_await task;
+            }
+            catch (...)
+            {
+                state->fail(std::current_exception());
+                co_return;
+            }
+
+            state->succeed(index);
         }
     };
 }
@@ -15,8 +15,6 @@ namespace zepo
         return static_cast<int>(detectedCount * 2);
     }
 
-    ThreadPool ThreadPool::defaultPool_{detectProcessorCount(), true};
-
     ThreadPool::ThreadPool(const int workerCount, bool startImmediately): workerCount_(workerCount)
     {
         workers_.reserve(workerCount);
@@ -62,7 +60,7 @@ namespace zepo
     void ThreadPool::put(Action&& func)
     {
         std::unique_lock lock{operationLock_};
-        workItems_.push(func);
+        workItems_.push(std::move(func));
         conditionVariable_.notify_one();
     }
 
@@ -71,8 +69,6 @@ namespace zepo
         Action func;
         while (true)
         {
-            std::this_thread::yield();
-
             {
                 std::unique_lock lock{operationLock_};
                 conditionVariable_.wait(lock, [this, &func]
@@ -96,6 +92,7 @@ namespace zepo
 
     ThreadPool& ThreadPool::getDefaultPool()
     {
-        return defaultPool_;
+        static ThreadPool defaultPool{detectProcessorCount(), true};
+        return defaultPool;
     }
 } // zepo
@@ -25,7 +25,6 @@ namespace zepo
         std::condition_variable conditionVariable_{};
         std::queue<Action> workItems_{};
         std::vector<std::thread> workers_{};
-        static ThreadPool defaultPool_;
 
         void worker();
 
@@ -51,6 +50,7 @@ namespace zepo
             return packagedTask->get_future();
         }
 
+        // started on first use
         static ThreadPool& getDefaultPool();
     };
 } // zepo
@@ -0,0 +1,274 @@
+//
+// Created by qingy on 2024/8/15.
+//
+
+#include "TimerWheel.hpp"
+
+#include <bit>
+#include <limits>
+#include <utility>
+
+namespace zepo
+{
+    TimerWheel::TimerWheel()
+    {
+        thread_ = std::thread{[this] { run(); }};
+    }
+
+    TimerWheel::~TimerWheel()
+    {
+        {
+            std::lock_guard lock{lock_};
+            running_ = false;
+        }
+
+        wakeCondition_.notify_one();
+        thread_.join();
+
+        // never fired, nobody is waiting for them anymore
+        for (auto* entry : incoming_)
+        {
+            delete entry;
+        }
+
+        for (auto& level : levels_)
+        {
+            for (auto* entry : level)
+            {
+                while (entry)
+                {
+                    delete std::exchange(entry, entry->next);
+                }
+            }
+        }
+    }
+
+    uint64_t TimerWheel::getTick(const Clock::time_point timePoint, const bool roundUp) const
+    {
+        const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(timePoint - startTime_).count();
+        if (elapsed <= 0) return 0;
+
+        // deadlines round up and the clock rounds down, so a timer never fires early
+        return static_cast<uint64_t>(roundUp ? (elapsed + 999) / 1000 : elapsed / 1000);
+    }
+
+    TimerWheel::Entry*& TimerWheel::getSlot(const Entry* entry)
+    {
+        return levels_[entry->level][(entry->deadline >> (entry->level * slotBits)) & (slotCount - 1)];
+    }
+
+    void TimerWheel::insert(Entry* entry, std::vector<Entry*>& expired)
+    {
+        if (entry->deadline <= currentTick_)
+        {
+            expired.push_back(entry);
+            return;
+        }
+
+        // the level is given by the highest bit in which the deadline differs from now,
+        // so a slot only ever holds timers that fall into it before the wheel wraps around
+        const auto difference = entry->deadline ^ currentTick_;
+        auto level = (63 - std::countl_zero(difference)) / slotBits;
+        if (level >= levelCount) level = levelCount - 1;
+
+        entry->level = level;
+        auto& slot = getSlot(entry);
+        entry->prev = nullptr;
+        entry->next = slot;
+        if (slot) slot->prev = entry;
+        slot = entry;
+        entry->linked = true;
+        entryCount_++;
+    }
+
+    void TimerWheel::unlink(Entry* entry)
+    {
+        if (entry->prev)
+        {
+            entry->prev->next = entry->next;
+        }
+        else
+        {
+            getSlot(entry) = entry->next;
+        }
+
+        if (entry->next) entry->next->prev = entry->prev;
+
+        entry->linked = false;
+        entryCount_--;
+    }
+
+    void TimerWheel::cancel(const uint64_t id)
+    {
+        const auto iter = pending_.find(id);
+        if (iter == pending_.end()) return;
+
+        auto* entry = iter->second;
+        pending_.erase(iter);
+
+        if (entry->linked)
+        {
+            unlink(entry);
+            delete entry;
+            return;
+        }
+
+        // already expired in this round, drop the captures now and skip it when firing
+        entry->cancelled = true;
+        entry->action = nullptr;
+    }
+
+    void TimerWheel::advance(const uint64_t tick, std::vector<Entry*>& expired)
+    {
+        while (currentTick_ < tick)
+        {
+            // nothing to fire on the way, jump
+            if (entryCount_ == 0)
+            {
+                currentTick_ = tick;
+                break;
+            }
+
+            ++currentTick_;
+
+            // entering a new slot of an upper level, spread it over the lower ones, highest first
+            int topLevel = 0;
+            while (topLevel + 1 < levelCount
+                && (currentTick_ & ((uint64_t{1} << ((topLevel + 1) * slotBits)) - 1)) == 0)
+            {
+                topLevel++;
+            }
+
+            for (auto level = topLevel; level > 0; --level)
+            {
+                auto* entry = std::exchange(levels_[level][(currentTick_ >> (level * slotBits)) & (slotCount - 1)],
+                                            nullptr);
+                while (entry)
+                {
+                    auto* next = entry->next;
+                    entry->linked = false;
+                    entryCount_--;
+                    insert(entry, expired);
+                    entry = next;
+                }
+            }
+
+            auto* entry = std::exchange(levels_[0][currentTick_ & (slotCount - 1)], nullptr);
+            while (entry)
+            {
+                auto* next = entry->next;
+                entry->linked = false;
+                entryCount_--;
+                expired.push_back(entry);
+                entry = next;
+            }
+        }
+    }
+
+    uint64_t TimerWheel::getNextWakeTick() const
+    {
+        if (entryCount_ == 0)
+        {
+            return std::numeric_limits<uint64_t>::max();
+        }
+
+        // the first busy slot of the lowest level, or the next cascade
+        const auto blockBase = currentTick_ & ~static_cast<uint64_t>(slotCount - 1);
+        for (auto index = (currentTick_ & (slotCount - 1)) + 1; index < slotCount; ++index)
+        {
+            if (levels_[0][index])
+            {
+                return blockBase + index;
+            }
+        }
+
+        return blockBase + slotCount;
+    }
+
+    void TimerWheel::run()
+    {
+        std::vector<Entry*> incoming{};
+        std::vector<uint64_t> cancelled{};
+        std::vector<Entry*> expired{};
+
+        std::unique_lock lock{lock_};
+        while (running_)
+        {
+            incoming.swap(incoming_);
+            cancelled.swap(cancelled_);
+            lock.unlock();
+
+            advance(getTick(Clock::now(), false), expired);
+            for (auto* entry : incoming)
+            {
+                pending_.emplace(entry->id, entry);
+                insert(entry, expired);
+            }
+            incoming.clear();
+
+            for (const auto id : cancelled)
+            {
+                cancel(id);
+            }
+            cancelled.clear();
+
+            for (auto* entry : expired)
+            {
+                if (!entry->cancelled)
+                {
+                    pending_.erase(entry->id);
+                    entry->action();
+                }
+
+                delete entry;
+            }
+            expired.clear();
+
+            const auto wakeTick = getNextWakeTick();
+
+            lock.lock();
+            if (!incoming_.empty() || !cancelled_.empty() || !running_) continue;
+
+            if (wakeTick == std::numeric_limits<uint64_t>::max())
+            {
+                wakeCondition_.wait(lock);
+            }
+            else
+            {
+                wakeCondition_.wait_until(lock, startTime_ + std::chrono::milliseconds{wakeTick});
+            }
+        }
+    }
+
+    TimerWheel::Handle TimerWheel::schedule(const Clock::duration delay, Action action)
+    {
+        auto* entry = new Entry{0, getTick(Clock::now() + delay, true), std::move(action)};
+
+        {
+            std::lock_guard lock{lock_};
+            entry->id = nextId_++;
+            incoming_.push_back(entry);
+        }
+
+        wakeCondition_.notify_one();
+        return Handle{this, entry->id};
+    }
+
+    void TimerWheel::Handle::cancel() const
+    {
+        if (!wheel_) return;
+
+        {
+            std::lock_guard lock{wheel_->lock_};
+            wheel_->cancelled_.push_back(id_);
+        }
+
+        wheel_->wakeCondition_.notify_one();
+    }
+
+    TimerWheel& TimerWheel::getDefault()
+    {
+        static TimerWheel defaultWheel{};
+        return defaultWheel;
+    }
+}
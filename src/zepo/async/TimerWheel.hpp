@@ -0,0 +1,125 @@
+//
+// Created by qingy on 2024/8/15.
+//
+
+#pragma once
+#ifndef ZEPO_TIMERWHEEL_HPP
+#define ZEPO_TIMERWHEEL_HPP
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace zepo
+{
+    class TimeoutException : public std::runtime_error
+    {
+    public:
+        TimeoutException() : std::runtime_error("operation timed out")
+        {
+        }
+    };
+
+    // hierarchical timer wheel with millisecond ticks, serviced by one timer thread.
+    // scheduling and cancelling are O(1) and a pending timer costs one small node, not a sleeping thread
+    class TimerWheel
+    {
+    public:
+        using Action = std::function<void()>;
+        using Clock = std::chrono::steady_clock;
+
+        // refers to a scheduled timer, cancelling is a no-op once it fired
+        class Handle
+        {
+            TimerWheel* wheel_{nullptr};
+            uint64_t id_{0};
+
+        public:
+            Handle() = default;
+
+            Handle(TimerWheel* wheel, const uint64_t id) : wheel_{wheel}, id_{id}
+            {
+            }
+
+            // the timer thread unlinks the timer and releases its action, unless it is already firing
+            void cancel() const;
+        };
+
+    private:
+        static constexpr int slotBits = 6;
+        static constexpr int slotCount = 1 << slotBits;
+        static constexpr int levelCount = 6;
+
+        struct Entry
+        {
+            uint64_t id;
+            uint64_t deadline;
+            Action action;
+            Entry* next{nullptr};
+            Entry* prev{nullptr};
+            // where it is linked, if it is in a slot at all
+            int level{0};
+            bool linked{false};
+            bool cancelled{false};
+        };
+
+        using Level = std::array<Entry*, slotCount>;
+
+        Clock::time_point startTime_{Clock::now()};
+
+        std::mutex lock_{};
+        std::condition_variable wakeCondition_{};
+        std::vector<Entry*> incoming_{};
+        std::vector<uint64_t> cancelled_{};
+        uint64_t nextId_{1};
+        bool running_{true};
+
+        // timer thread only
+        std::array<Level, levelCount> levels_{};
+        // every timer taken in and not fired or cancelled yet, by id
+        std::unordered_map<uint64_t, Entry*> pending_{};
+        uint64_t currentTick_{0};
+        size_t entryCount_{0};
+
+        std::thread thread_{};
+
+        [[nodiscard]] uint64_t getTick(Clock::time_point timePoint, bool roundUp) const;
+
+        Entry*& getSlot(const Entry* entry);
+
+        void insert(Entry* entry, std::vector<Entry*>& expired);
+
+        void unlink(Entry* entry);
+
+        void cancel(uint64_t id);
+
+        void advance(uint64_t tick, std::vector<Entry*>& expired);
+
+        [[nodiscard]] uint64_t getNextWakeTick() const;
+
+        void run();
+
+    public:
+        TimerWheel();
+
+        TimerWheel(const TimerWheel&) = delete;
+
+        TimerWheel(TimerWheel&&) = delete;
+
+        ~TimerWheel();
+
+        // runs `action` on the timer thread once `delay` elapsed, keep it short
+        Handle schedule(Clock::duration delay, Action action);
+
+        static TimerWheel& getDefault();
+    };
+}
+
+#endif //ZEPO_TIMERWHEEL_HPP
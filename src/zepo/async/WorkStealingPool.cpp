@@ -0,0 +1,318 @@
+//
+// Created by qingy on 2024/8/8.
+//
+
+#include "WorkStealingPool.hpp"
+
+#include <algorithm>
+
+namespace zepo
+{
+    namespace internal
+    {
+        WorkStealingDeque::Buffer::Buffer(const int64_t capacity)
+            : capacity{capacity}, items{std::make_unique<std::atomic<PoolJob*>[]>(capacity)}
+        {
+        }
+
+        PoolJob* WorkStealingDeque::Buffer::get(const int64_t index) const
+        {
+            return items[index & (capacity - 1)].load(std::memory_order_relaxed);
+        }
+
+        void WorkStealingDeque::Buffer::put(const int64_t index, PoolJob* job) const
+        {
+            items[index & (capacity - 1)].store(job, std::memory_order_relaxed);
+        }
+
+        WorkStealingDeque::WorkStealingDeque(const int64_t capacity)
+        {
+            buffers_.push_back(std::make_unique<Buffer>(capacity));
+            buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+        }
+
+        WorkStealingDeque::~WorkStealingDeque()
+        {
+            while (auto* job = pop())
+            {
+                delete job;
+            }
+        }
+
+        WorkStealingDeque::Buffer* WorkStealingDeque::grow(Buffer* buffer, const int64_t top, const int64_t bottom)
+        {
+            auto& grown = buffers_.emplace_back(std::make_unique<Buffer>(buffer->capacity * 2));
+            for (auto i = top; i != bottom; ++i)
+            {
+                grown->put(i, buffer->get(i));
+            }
+
+            buffer_.store(grown.get(), std::memory_order_release);
+            return grown.get();
+        }
+
+        void WorkStealingDeque::push(PoolJob* job)
+        {
+            const auto bottom = bottom_.load(std::memory_order_relaxed);
+            const auto top = top_.load(std::memory_order_acquire);
+            auto* buffer = buffer_.load(std::memory_order_relaxed);
+
+            if (bottom - top > buffer->capacity - 1)
+            {
+                buffer = grow(buffer, top, bottom);
+            }
+
+            buffer->put(bottom, job);
+            std::atomic_thread_fence(std::memory_order_release);
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+        }
+
+        PoolJob* WorkStealingDeque::pop()
+        {
+            const auto bottom = bottom_.load(std::memory_order_relaxed) - 1;
+            const auto* buffer = buffer_.load(std::memory_order_relaxed);
+            bottom_.store(bottom, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto top = top_.load(std::memory_order_relaxed);
+
+            if (top > bottom)
+            {
+                // empty
+                bottom_.store(bottom + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+
+            auto* job = buffer->get(bottom);
+            if (top == bottom)
+            {
+                // the last one, race with the thieves
+                if (!top_.compare_exchange_strong(top, top + 1,
+                                                  std::memory_order_seq_cst, std::memory_order_relaxed))
+                {
+                    job = nullptr;
+                }
+
+                bottom_.store(bottom + 1, std::memory_order_relaxed);
+            }
+
+            return job;
+        }
+
+        PoolJob* WorkStealingDeque::steal()
+        {
+            auto top = top_.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const auto bottom = bottom_.load(std::memory_order_acquire);
+
+            if (top >= bottom)
+            {
+                return nullptr;
+            }
+
+            const auto* buffer = buffer_.load(std::memory_order_acquire);
+            auto* job = buffer->get(top);
+            if (!top_.compare_exchange_strong(top, top + 1,
+                                              std::memory_order_seq_cst, std::memory_order_relaxed))
+            {
+                return nullptr;
+            }
+
+            return job;
+        }
+
+        bool WorkStealingDeque::empty() const
+        {
+            return top_.load(std::memory_order_relaxed) >= bottom_.load(std::memory_order_relaxed);
+        }
+    }
+
+    namespace
+    {
+        thread_local WorkStealingPool* currentPool{nullptr};
+        thread_local int currentWorkerIndex{-1};
+
+        int detectProcessorCount()
+        {
+            const auto detectedCount = std::thread::hardware_concurrency();
+            return detectedCount ? static_cast<int>(detectedCount) : 1;
+        }
+    }
+
+    WorkStealingPool::WorkStealingPool(const int workerCount, const bool startImmediately)
+        : workerCount_{workerCount > 0 ? workerCount : 1}
+    {
+        workers_.reserve(workerCount_);
+        for (int i = 0; i < workerCount_; ++i)
+        {
+            workers_.push_back(std::make_unique<Worker>());
+        }
+
+        if (startImmediately)
+        {
+            start();
+        }
+    }
+
+    WorkStealingPool::~WorkStealingPool()
+    {
+        stop();
+
+        for (auto* job : injectedJobs_)
+        {
+            delete job;
+        }
+    }
+
+    void WorkStealingPool::start()
+    {
+        if (started_.exchange(true)) return;
+
+        for (int i = 0; i < workerCount_; ++i)
+        {
+            workers_[i]->thread = std::thread{[this, i] { worker(i); }};
+        }
+    }
+
+    void WorkStealingPool::stop()
+    {
+        if (!started_.exchange(false)) return;
+
+        wakeEpoch_.fetch_add(1, std::memory_order_seq_cst);
+        wakeEpoch_.notify_all();
+
+        for (const auto& worker : workers_)
+        {
+            if (worker->thread.joinable())
+            {
+                worker->thread.join();
+            }
+        }
+    }
+
+    void WorkStealingPool::put(const Action& func)
+    {
+        put(Action{func});
+    }
+
+    void WorkStealingPool::put(Action&& func)
+    {
+        auto* job = new internal::PoolJob{std::move(func)};
+
+        if (currentPool == this)
+        {
+            workers_[currentWorkerIndex]->deque.push(job);
+        }
+        else
+        {
+            std::lock_guard lock{injectionLock_};
+            injectedJobs_.push_back(job);
+            injectedCount_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        wakeOne();
+    }
+
+    void WorkStealingPool::wakeOne()
+    {
+        // pairs with the sleeper announcement in worker(): either the sleeper finds the job when it checks
+        // again, or we see the sleeper here and bump the epoch it waits on
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeperCount_.load(std::memory_order_relaxed) > 0)
+        {
+            wakeEpoch_.fetch_add(1, std::memory_order_seq_cst);
+            wakeEpoch_.notify_one();
+        }
+    }
+
+    internal::PoolJob* WorkStealingPool::findJob(const int index)
+    {
+        // local, LIFO
+        if (auto* job = workers_[index]->deque.pop())
+        {
+            return job;
+        }
+
+        // injected from outside
+        if (injectedCount_.load(std::memory_order_relaxed) > 0)
+        {
+            std::lock_guard lock{injectionLock_};
+            if (!injectedJobs_.empty())
+            {
+                auto* job = injectedJobs_.front();
+                injectedJobs_.pop_front();
+                injectedCount_.fetch_sub(1, std::memory_order_relaxed);
+                return job;
+            }
+        }
+
+        // steal from the others, FIFO
+        for (int i = 1; i < workerCount_; ++i)
+        {
+            if (auto* job = workers_[(index + i) % workerCount_]->deque.steal())
+            {
+                return job;
+            }
+        }
+
+        return nullptr;
+    }
+
+    void WorkStealingPool::worker(const int index)
+    {
+        currentPool = this;
+        currentWorkerIndex = index;
+        setCurrent(this);
+
+        constexpr int spinCount = 64;
+
+        while (started_.load(std::memory_order_acquire))
+        {
+            internal::PoolJob* job{nullptr};
+            for (int spin = 0; spin < spinCount && !job; ++spin)
+            {
+                job = findJob(index);
+            }
+
+            if (!job)
+            {
+                // announce the sleep before checking again, so a put in between bumps the epoch we wait on
+                sleeperCount_.fetch_add(1, std::memory_order_seq_cst);
+                const auto epoch = wakeEpoch_.load(std::memory_order_seq_cst);
+
+                job = findJob(index);
+                if (!job && started_.load(std::memory_order_acquire))
+                {
+                    wakeEpoch_.wait(epoch, std::memory_order_seq_cst);
+                }
+
+                sleeperCount_.fetch_sub(1, std::memory_order_seq_cst);
+                if (!job) continue;
+            }
+
+            job->action();
+            delete job;
+        }
+
+        currentPool = nullptr;
+        currentWorkerIndex = -1;
+        setCurrent(nullptr);
+    }
+
+    int WorkStealingPool::getWorkerCount() const
+    {
+        return workerCount_;
+    }
+
+    WorkStealingPool& WorkStealingPool::getCpuPool()
+    {
+        static WorkStealingPool cpuPool{detectProcessorCount(), true};
+        return cpuPool;
+    }
+
+    WorkStealingPool& WorkStealingPool::getBlockingPool()
+    {
+        // threads parked in system calls don't use their core, keep some spare
+        static WorkStealingPool blockingPool{std::max(4, detectProcessorCount() * 2), true};
+        return blockingPool;
+    }
+} // zepo
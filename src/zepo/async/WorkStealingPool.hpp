@@ -0,0 +1,130 @@
+//
+// Created by qingy on 2024/8/8.
+//
+
+#pragma once
+#ifndef ZEPO_WORKSTEALINGPOOL_HPP
+#define ZEPO_WORKSTEALINGPOOL_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "zepo/async/Executor.hpp"
+
+namespace zepo
+{
+    namespace internal
+    {
+        struct PoolJob
+        {
+            std::function<void()> action;
+        };
+
+        // Chase-Lev deque, the owner pushes and pops at the bottom (LIFO),
+        // other workers steal from the top (FIFO)
+        class WorkStealingDeque
+        {
+            struct Buffer
+            {
+                int64_t capacity;
+                std::unique_ptr<std::atomic<PoolJob*>[]> items;
+
+                explicit Buffer(int64_t capacity);
+
+                [[nodiscard]] PoolJob* get(int64_t index) const;
+
+                void put(int64_t index, PoolJob* job) const;
+            };
+
+            alignas(64) std::atomic<int64_t> top_{0};
+            alignas(64) std::atomic<int64_t> bottom_{0};
+            std::atomic<Buffer*> buffer_;
+
+            // retired buffers may still be read by a thief, they are released with the deque
+            std::vector<std::unique_ptr<Buffer>> buffers_{};
+
+            Buffer* grow(Buffer* buffer, int64_t top, int64_t bottom);
+
+        public:
+            explicit WorkStealingDeque(int64_t capacity = 256);
+
+            WorkStealingDeque(const WorkStealingDeque&) = delete;
+
+            WorkStealingDeque(WorkStealingDeque&&) = delete;
+
+            ~WorkStealingDeque();
+
+            // owner only
+            void push(PoolJob* job);
+
+            // owner only
+            PoolJob* pop();
+
+            // any thread
+            PoolJob* steal();
+
+            [[nodiscard]] bool empty() const;
+        };
+    }
+
+    class WorkStealingPool final : public Executor
+    {
+        struct Worker
+        {
+            internal::WorkStealingDeque deque{};
+            std::thread thread{};
+        };
+
+        int workerCount_;
+        std::atomic<bool> started_{false};
+        std::vector<std::unique_ptr<Worker>> workers_{};
+
+        // jobs put from threads outside of the pool
+        std::mutex injectionLock_{};
+        std::deque<internal::PoolJob*> injectedJobs_{};
+        std::atomic<size_t> injectedCount_{0};
+
+        // parking: sleepers wait on the epoch, every put bumps it
+        alignas(64) std::atomic<uint32_t> wakeEpoch_{0};
+        alignas(64) std::atomic<int> sleeperCount_{0};
+
+        void worker(int index);
+
+        internal::PoolJob* findJob(int index);
+
+        void wakeOne();
+
+    public:
+        explicit WorkStealingPool(int workerCount, bool startImmediately = false);
+
+        WorkStealingPool(const WorkStealingPool&) = delete;
+
+        WorkStealingPool(WorkStealingPool&&) = delete;
+
+        ~WorkStealingPool();
+
+        void start();
+
+        void stop();
+
+        void put(const Action& func);
+
+        void put(Action&& func) override;
+
+        [[nodiscard]] int getWorkerCount() const;
+
+        // CPU-bound work (parsing, semver matching), one worker per core
+        static WorkStealingPool& getCpuPool();
+
+        // blocking file system work (extraction, hashing, syncing)
+        static WorkStealingPool& getBlockingPool();
+    };
+} // zepo
+
+#endif //ZEPO_WORKSTEALINGPOOL_HPP
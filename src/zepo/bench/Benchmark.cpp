@@ -0,0 +1,171 @@
+//
+// Created by qingy on 2024/8/8.
+//
+
+#include "Benchmark.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <vector>
+
+namespace zepo::bench {
+    static thread_local uint64_t allocationCount{0};
+
+    uint64_t getAllocationCount() noexcept {
+        return allocationCount;
+    }
+
+    struct RegisteredBenchmark {
+        std::string name;
+        BenchmarkFunction function;
+    };
+
+    static std::vector<RegisteredBenchmark>& getBenchmarks() {
+        static std::vector<RegisteredBenchmark> benchmarks{};
+        return benchmarks;
+    }
+
+    void BenchmarkContext::setCounter(const std::string& name, const double value) {
+        counters_[name] = value;
+    }
+
+    uint64_t BenchmarkContext::getOperations() const {
+        return operations_;
+    }
+
+    long BenchmarkContext::getElapsedNanoseconds() const {
+        return elapsedNanoseconds_;
+    }
+
+    const std::map<std::string, double>& BenchmarkContext::getCounters() const {
+        return counters_;
+    }
+
+    bool registerBenchmark(const std::string_view name, BenchmarkFunction function) {
+        getBenchmarks().push_back({std::string{name}, std::move(function)});
+        return true;
+    }
+}
+
+void* operator new(const std::size_t size) {
+    zepo::bench::allocationCount++;
+    if (auto* ptr = std::malloc(size > 0 ? size : 1)) {
+        return ptr;
+    }
+
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+namespace {
+    struct BenchmarkResult {
+        std::string_view name;
+        uint64_t operations;
+        double nanosecondsPerOperation;
+        std::map<std::string, double> counters;
+    };
+
+    void printText(const BenchmarkResult& result) {
+        std::cout << std::left << std::setw(48) << result.name << std::right
+                << std::setw(12) << std::fixed << std::setprecision(1) << result.nanosecondsPerOperation << " ns/op"
+                << std::setw(14) << std::setprecision(0) << 1e9 / result.nanosecondsPerOperation << " op/s";
+
+        for (const auto& [counterName, value]: result.counters) {
+            std::cout << "  " << counterName << "=" << std::setprecision(2) << value;
+        }
+
+        std::cout << std::endl;
+    }
+
+    // one benchmark per line in name order with fixed keys and precision, so two runs diff line by line
+    void printJson(const std::vector<BenchmarkResult>& results) {
+        std::cout << "{\n  \"benchmarks\": [";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const auto& result = results[i];
+            std::cout << (i == 0 ? "\n" : ",\n")
+                    << "    {\"name\": \"" << result.name << "\""
+                    << ", \"operations\": " << result.operations
+                    << std::fixed << std::setprecision(3)
+                    << ", \"ns_per_op\": " << result.nanosecondsPerOperation
+                    << ", \"ops_per_second\": " << std::setprecision(0) << 1e9 / result.nanosecondsPerOperation
+                    << ", \"counters\": {";
+
+            auto first = true;
+            for (const auto& [counterName, value]: result.counters) {
+                std::cout << (first ? "" : ", ") << "\"" << counterName << "\": " << std::setprecision(3) << value;
+                first = false;
+            }
+
+            std::cout << "}}";
+        }
+
+        std::cout << (results.empty() ? "" : "\n  ") << "]\n}" << std::endl;
+    }
+}
+
+// zepo_bench [--json] [filter], runs the benchmarks whose name contains `filter`
+int main(int argc, char** argv) {
+    using namespace zepo::bench;
+
+    constexpr int repetitions = 5;
+    bool jsonOutput{false};
+    std::string_view filter{};
+
+    for (int i = 1; i < argc; ++i) {
+        if (const std::string_view argument{argv[i]}; argument == "--json") {
+            jsonOutput = true;
+        } else {
+            filter = argument;
+        }
+    }
+
+    auto& benchmarks = getBenchmarks();
+    std::ranges::sort(benchmarks, {}, &RegisteredBenchmark::name);
+
+    std::vector<BenchmarkResult> results{};
+    for (const auto& [name, function]: benchmarks) {
+        if (name.find(filter) == std::string::npos) continue;
+
+        // report the fastest run, the others are mostly scheduling noise
+        BenchmarkContext best{};
+        for (int i = 0; i < repetitions; ++i) {
+            BenchmarkContext context{};
+            function(context);
+
+            if (i == 0 || context.getElapsedNanoseconds() < best.getElapsedNanoseconds()) {
+                best = context;
+            }
+        }
+
+        const auto operations = std::max<uint64_t>(best.getOperations(), 1);
+        BenchmarkResult result{
+            name,
+            operations,
+            static_cast<double>(std::max<long>(best.getElapsedNanoseconds(), 1)) / operations,
+            best.getCounters()
+        };
+
+        // the text report streams, the JSON one is written once complete
+        if (jsonOutput) {
+            results.push_back(std::move(result));
+        } else {
+            printText(result);
+        }
+    }
+
+    if (jsonOutput) {
+        printJson(results);
+    }
+
+    return 0;
+}
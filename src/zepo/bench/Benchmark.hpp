@@ -0,0 +1,70 @@
+//
+// Created by qingy on 2024/8/8.
+//
+
+#pragma once
+#ifndef ZEPO_BENCHMARK_HPP
+#define ZEPO_BENCHMARK_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+
+namespace zepo::bench {
+    class BenchmarkContext {
+        uint64_t operations_{0};
+        long elapsedNanoseconds_{0};
+        std::map<std::string, double> counters_{};
+
+    public:
+        // time `body`, which performs `operations` operations; call it once per benchmark run
+        template<typename Body>
+        void measure(const uint64_t operations, Body&& body) {
+            const auto beginTime = std::chrono::steady_clock::now();
+            body();
+            const auto endTime = std::chrono::steady_clock::now();
+
+            operations_ = operations;
+            elapsedNanoseconds_ = std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - beginTime).count();
+        }
+
+        void setCounter(const std::string& name, double value);
+
+        [[nodiscard]] uint64_t getOperations() const;
+
+        [[nodiscard]] long getElapsedNanoseconds() const;
+
+        [[nodiscard]] const std::map<std::string, double>& getCounters() const;
+    };
+
+    using BenchmarkFunction = std::function<void(BenchmarkContext&)>;
+
+    bool registerBenchmark(std::string_view name, BenchmarkFunction function);
+
+    // heap allocations made by the calling thread so far, the bench replaces the global operator new
+    uint64_t getAllocationCount() noexcept;
+
+    // keep the optimizer from dropping a computed value
+    template<typename T>
+    void doNotOptimize(T&& value) {
+#if defined(_MSC_VER)
+        static volatile const void* sink;
+        sink = &value;
+#else
+        asm volatile("" : : "r,m"(value) : "memory");
+#endif
+    }
+}
+
+#ifndef ZEPO_NO_MACROS
+
+#define ZEPO_BENCHMARK_(NAME_) static void bench_##NAME_(zepo::bench::BenchmarkContext& context); \
+static const bool benchRegistered_##NAME_ = zepo::bench::registerBenchmark(#NAME_, bench_##NAME_); \
+static void bench_##NAME_(zepo::bench::BenchmarkContext& context)
+
+#endif //ZEPO_NO_MACROS
+
+#endif //ZEPO_BENCHMARK_HPP
@@ -0,0 +1,130 @@
+//
+// Created by qingy on 2024/8/17.
+//
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Benchmark.hpp"
+#include "zepo/container/FlatMap.hpp"
+#include "zepo/container/StringPool.hpp"
+#include "zepo/serialize/Binary.hpp"
+
+namespace {
+    constexpr int decodeRounds = 20;
+
+    // shaped like the versions of a packument as the resolver keeps them
+    struct CachedVersion {
+        std::string_view version;
+        std::string_view tarball;
+        std::string_view integrity;
+        zepo::FlatMap<std::string_view, std::string_view> dependencies;
+    };
+
+    struct CachedPackage {
+        std::string name;
+        std::vector<CachedVersion> versions;
+    };
+
+    // the same with owned strings, every string is copied out on decode
+    struct OwnedVersion {
+        std::string version;
+        std::string tarball;
+        std::string integrity;
+        zepo::FlatMap<std::string, std::string> dependencies;
+    };
+
+    struct OwnedPackage {
+        std::string name;
+        std::vector<OwnedVersion> versions;
+    };
+}
+
+ZEPO_REFLECT_INFO_BEGIN_(CachedVersion)
+    ZEPO_REFLECT_FIELD_(version);
+    ZEPO_REFLECT_FIELD_(tarball);
+    ZEPO_REFLECT_FIELD_(integrity);
+    ZEPO_REFLECT_FIELD_(dependencies);
+ZEPO_REFLECT_INFO_END_()
+
+ZEPO_REFLECT_INFO_BEGIN_(CachedPackage)
+    ZEPO_REFLECT_FIELD_(name);
+    ZEPO_REFLECT_FIELD_(versions);
+ZEPO_REFLECT_INFO_END_()
+
+ZEPO_REFLECT_INFO_BEGIN_(OwnedVersion)
+    ZEPO_REFLECT_FIELD_(version);
+    ZEPO_REFLECT_FIELD_(tarball);
+    ZEPO_REFLECT_FIELD_(integrity);
+    ZEPO_REFLECT_FIELD_(dependencies);
+ZEPO_REFLECT_INFO_END_()
+
+ZEPO_REFLECT_INFO_BEGIN_(OwnedPackage)
+    ZEPO_REFLECT_FIELD_(name);
+    ZEPO_REFLECT_FIELD_(versions);
+ZEPO_REFLECT_INFO_END_()
+
+namespace {
+    // 2000 versions with a dozen dependencies each, most dependency names repeat across versions
+    const std::string& getEncodedPackage() {
+        static const auto encoded = [] {
+            zepo::StringPool strings{};
+            const auto store = [&strings](const std::string& value) {
+                return strings.store(value);
+            };
+
+            CachedPackage package{"large-package", {}};
+            for (int i = 0; i < 2000; ++i) {
+                const auto version = store(std::to_string(i / 100) + "." + std::to_string(i / 10 % 10) + "."
+                                           + std::to_string(i % 10));
+                std::vector<std::pair<std::string_view, std::string_view>> dependencies{};
+                for (int j = 0; j < 12; ++j) {
+                    dependencies.emplace_back(store("dependency-package-" + std::to_string((i / 50 + j) % 32)),
+                                              "^1.0.0");
+                }
+
+                package.versions.push_back({
+                    version,
+                    store("https://registry.npmjs.org/large-package/-/large-package-" + std::string{version} + ".tgz"),
+                    store("sha512-" + std::string(86, static_cast<char>('a' + i % 26))),
+                    zepo::FlatMap<std::string_view, std::string_view>::fromUnsorted(std::move(dependencies)),
+                });
+            }
+
+            return zepo::encodeBinary(package);
+        }();
+        return encoded;
+    }
+
+    template<typename Package>
+    void benchmarkDecode(zepo::bench::BenchmarkContext& context) {
+        // the two packages share a schema fingerprint, the owned one decodes the same buffer
+        const auto& encoded = getEncodedPackage();
+        const auto allocationsBefore = zepo::bench::getAllocationCount();
+
+        context.measure(decodeRounds, [&] {
+            for (int round = 0; round < decodeRounds; ++round) {
+                auto package = zepo::decodeBinary<Package>(encoded);
+                zepo::bench::doNotOptimize(package);
+            }
+        });
+
+        context.setCounter("buffer_bytes", static_cast<double>(encoded.size()));
+        context.setCounter("allocations_per_op",
+                           static_cast<double>(zepo::bench::getAllocationCount() - allocationsBefore)
+                           / decodeRounds);
+    }
+}
+
+static_assert(zepo::BinaryTraits<CachedPackage>::fingerprint == zepo::BinaryTraits<OwnedPackage>::fingerprint);
+
+// one op is one package of 2000 versions
+ZEPO_BENCHMARK_(binary_package_decode_views) {
+    benchmarkDecode<CachedPackage>(context);
+}
+
+ZEPO_BENCHMARK_(binary_package_decode_owned) {
+    benchmarkDecode<OwnedPackage>(context);
+}
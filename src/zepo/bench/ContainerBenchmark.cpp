@@ -0,0 +1,147 @@
+//
+// Created by qingy on 2024/8/16.
+//
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "Benchmark.hpp"
+#include "zepo/container/FlatMap.hpp"
+#include "zepo/container/HashMap.hpp"
+#include "zepo/serialize/Serializer.hpp"
+
+namespace {
+    constexpr int parseRounds = 200;
+    constexpr int lookupRounds = 200;
+    constexpr int dependencyRounds = 20000;
+
+    // an already parsed JSON object of strings, so only the container side is measured
+    struct ObjectToken {
+        using Members = std::vector<std::pair<std::string, std::string>>;
+
+        const Members* members{nullptr};
+        std::string_view value{};
+
+        void forEach(const std::function<bool(std::string_view, ObjectToken)>& action) const {
+            for (const auto& [key, item]: *members) {
+                if (action(key, ObjectToken{nullptr, item})) break;
+            }
+        }
+
+        void forEach(const std::function<bool(ObjectToken)>&) const {
+        }
+
+        [[nodiscard]] std::string_view toStringView() const {
+            return value;
+        }
+    };
+
+    // the `versions` of a large packument like @types/node, in publish order
+    const ObjectToken::Members& getPackumentVersions() {
+        static const auto versions = [] {
+            ObjectToken::Members result{};
+            for (int major = 0; major < 20; ++major) {
+                for (int minor = 0; minor < 10; ++minor) {
+                    for (int patch = 0; patch < 10; ++patch) {
+                        auto version = std::to_string(major) + "." + std::to_string(minor) + "." + std::to_string(patch);
+                        result.emplace_back(version, "https://registry.npmjs.org/-/" + version + ".tgz");
+                    }
+                }
+            }
+            return result;
+        }();
+        return versions;
+    }
+
+    // the `dependencies` of one version
+    const ObjectToken::Members& getDependencies() {
+        static const auto dependencies = [] {
+            ObjectToken::Members result{};
+            for (int i = 0; i < 24; ++i) {
+                result.emplace_back("dependency-package-" + std::to_string(i * 7919 % 24), "^" + std::to_string(i) + ".0.0");
+            }
+            return result;
+        }();
+        return dependencies;
+    }
+
+    template<typename Map>
+    void benchmarkParse(zepo::bench::BenchmarkContext& context, const ObjectToken::Members& members,
+                        const int rounds) {
+        const ObjectToken token{&members};
+        const auto allocationsBefore = zepo::bench::getAllocationCount();
+
+        context.measure(members.size() * rounds, [&] {
+            for (int round = 0; round < rounds; ++round) {
+                auto result = zepo::parse<Map>(token);
+                zepo::bench::doNotOptimize(result);
+            }
+        });
+
+        context.setCounter("allocations_per_key",
+                           static_cast<double>(zepo::bench::getAllocationCount() - allocationsBefore)
+                           / static_cast<double>(members.size() * rounds));
+    }
+
+    template<typename Map>
+    void benchmarkLookup(zepo::bench::BenchmarkContext& context, const ObjectToken::Members& members) {
+        const auto map = zepo::parse<Map>(ObjectToken{&members});
+        size_t found{0};
+
+        context.measure(members.size() * lookupRounds, [&] {
+            for (int round = 0; round < lookupRounds; ++round) {
+                for (const auto& [key, value]: members) {
+                    found += map.find(std::string_view{key}) != map.end();
+                }
+            }
+        });
+
+        zepo::bench::doNotOptimize(found);
+    }
+
+    using StdMap = std::map<std::string_view, std::string_view>;
+    using Flat = zepo::FlatMap<std::string_view, std::string_view>;
+    using Hash = zepo::HashMap<std::string_view, std::string_view>;
+}
+
+// one op is one key
+ZEPO_BENCHMARK_(packument_versions_parse_std_map) {
+    benchmarkParse<StdMap>(context, getPackumentVersions(), parseRounds);
+}
+
+ZEPO_BENCHMARK_(packument_versions_parse_flat_map) {
+    benchmarkParse<Flat>(context, getPackumentVersions(), parseRounds);
+}
+
+ZEPO_BENCHMARK_(packument_versions_parse_hash_map) {
+    benchmarkParse<Hash>(context, getPackumentVersions(), parseRounds);
+}
+
+ZEPO_BENCHMARK_(packument_versions_lookup_std_map) {
+    benchmarkLookup<StdMap>(context, getPackumentVersions());
+}
+
+ZEPO_BENCHMARK_(packument_versions_lookup_flat_map) {
+    benchmarkLookup<Flat>(context, getPackumentVersions());
+}
+
+ZEPO_BENCHMARK_(packument_versions_lookup_hash_map) {
+    benchmarkLookup<Hash>(context, getPackumentVersions());
+}
+
+ZEPO_BENCHMARK_(version_dependencies_parse_std_map) {
+    benchmarkParse<StdMap>(context, getDependencies(), dependencyRounds);
+}
+
+ZEPO_BENCHMARK_(version_dependencies_parse_flat_map) {
+    benchmarkParse<Flat>(context, getDependencies(), dependencyRounds);
+}
+
+ZEPO_BENCHMARK_(version_dependencies_parse_hash_map) {
+    benchmarkParse<Hash>(context, getDependencies(), dependencyRounds);
+}
@@ -0,0 +1,104 @@
+//
+// Created by qingy on 2024/8/12.
+//
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include "Benchmark.hpp"
+#include "zepo/async/FrameAllocator.hpp"
+#include "zepo/async/Task.hpp"
+
+namespace {
+    constexpr int churnDepth = 8;
+    constexpr int churnRounds = 20000;
+
+    struct GlobalAllocator {
+        static void* allocate(const std::size_t size) {
+            return ::operator new(size);
+        }
+
+        static void deallocate(void* ptr, std::size_t) noexcept {
+            ::operator delete(ptr);
+        }
+    };
+
+    // the allocation pattern of a coroutine chain: frames of mixed sizes, freed in reverse order
+    template<typename Allocator>
+    void allocateChain(int& counter) {
+        constexpr std::size_t frameSizes[churnDepth + 1]{192, 448, 320, 576, 256, 384, 512, 224, 640};
+        void* frames[churnDepth + 1];
+
+        for (int i = 0; i <= churnDepth; ++i) {
+            frames[i] = Allocator::allocate(frameSizes[i]);
+            zepo::bench::doNotOptimize(frames[i]);
+            counter++;
+        }
+
+        for (int i = churnDepth; i >= 0; --i) {
+            Allocator::deallocate(frames[i], frameSizes[i]);
+        }
+    }
+
+    zepo::Task<> pooledChain(const int depth, int& counter) {
+        counter++;
+        if (depth > 0) {
+            co_await pooledChain(depth - 1, counter);
+        }
+    }
+
+    // every thread builds and tears down short coroutine chains, like a resolver walking a tree
+    template<typename Body>
+    void runChurn(zepo::bench::BenchmarkContext& context, const int threadCount, Body&& body) {
+        const auto before = zepo::internal::FrameAllocator::getStatistics();
+
+        context.measure(static_cast<uint64_t>(threadCount) * churnRounds * (churnDepth + 1), [&] {
+            std::vector<std::thread> threads{};
+            for (int i = 0; i < threadCount; ++i) {
+                threads.emplace_back([&] {
+                    int counter{0};
+                    for (int round = 0; round < churnRounds; ++round) {
+                        body(counter);
+                    }
+
+                    zepo::bench::doNotOptimize(counter);
+                });
+            }
+
+            for (auto& thread: threads) {
+                thread.join();
+            }
+        });
+
+        const auto after = zepo::internal::FrameAllocator::getStatistics();
+        if (const auto allocated = after.allocated - before.allocated; allocated > 0) {
+            context.setCounter("recycled_ratio", static_cast<double>(after.recycled - before.recycled) / allocated);
+        }
+    }
+}
+
+ZEPO_BENCHMARK_(frame_alloc_1_thread_global_new) {
+    runChurn(context, 1, [](int& counter) { allocateChain<GlobalAllocator>(counter); });
+}
+
+ZEPO_BENCHMARK_(frame_alloc_1_thread_pooled) {
+    runChurn(context, 1, [](int& counter) { allocateChain<zepo::internal::FrameAllocator>(counter); });
+}
+
+ZEPO_BENCHMARK_(frame_alloc_8_threads_global_new) {
+    runChurn(context, 8, [](int& counter) { allocateChain<GlobalAllocator>(counter); });
+}
+
+ZEPO_BENCHMARK_(frame_alloc_8_threads_pooled) {
+    runChurn(context, 8, [](int& counter) { allocateChain<zepo::internal::FrameAllocator>(counter); });
+}
+
+// whole Task coroutines, reports how many frames came from the free lists
+ZEPO_BENCHMARK_(frame_churn_task_chain_1_thread) {
+    runChurn(context, 1, [](int& counter) { pooledChain(churnDepth, counter).wait(); });
+}
+
+ZEPO_BENCHMARK_(frame_churn_task_chain_8_threads) {
+    runChurn(context, 8, [](int& counter) { pooledChain(churnDepth, counter).wait(); });
+}
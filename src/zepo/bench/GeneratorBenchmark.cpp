@@ -0,0 +1,72 @@
+//
+// Created by qingy on 2024/8/15.
+//
+
+#include <cstdint>
+#include <string_view>
+
+#include "Benchmark.hpp"
+#include "zepo/async/Generator.hpp"
+#include "zepo/semver/Range.hpp"
+
+namespace {
+    constexpr int yieldCount = 1000000;
+    constexpr int lexerRounds = 20000;
+
+    // the shapes the resolver meets in package.json files
+    constexpr std::string_view rangeExpressions[]{
+        "^1.2.3",
+        "~4.17.21",
+        ">=1.0.0 <2.0.0-beta.1",
+        "1.x || >=2.5.0 || 5.0.0 - 7.2.3",
+        "*",
+        "=v3.0.0",
+        ">2.1 <=3.0.0 || ^4.0.0-rc.2",
+    };
+
+    zepo::Generator<int64_t> countTo(const int64_t count) {
+        for (int64_t i = 0; i < count; ++i) {
+            co_yield i;
+        }
+    }
+}
+
+ZEPO_BENCHMARK_(generator_iterate_1m_yields) {
+    int64_t sum{0};
+    const auto allocationsBefore = zepo::bench::getAllocationCount();
+
+    context.measure(yieldCount, [&] {
+        for (const auto value: countTo(yieldCount)) {
+            sum += value;
+        }
+    });
+
+    zepo::bench::doNotOptimize(sum);
+    context.setCounter("allocations_per_yield",
+                       static_cast<double>(zepo::bench::getAllocationCount() - allocationsBefore) / yieldCount);
+}
+
+// one op is one token, the generator frame itself comes from the frame pool
+ZEPO_BENCHMARK_(semver_lexer_tokens) {
+    uint64_t tokensPerRound{0};
+    for (const auto expression: rangeExpressions) {
+        for ([[maybe_unused]] const auto& token: zepo::semver::Range::lexer(expression)) {
+            tokensPerRound++;
+        }
+    }
+
+    const auto allocationsBefore = zepo::bench::getAllocationCount();
+    context.measure(tokensPerRound * lexerRounds, [&] {
+        for (int round = 0; round < lexerRounds; ++round) {
+            for (const auto expression: rangeExpressions) {
+                for (const auto& token: zepo::semver::Range::lexer(expression)) {
+                    zepo::bench::doNotOptimize(token.type);
+                }
+            }
+        }
+    });
+
+    context.setCounter("allocations_per_token",
+                       static_cast<double>(zepo::bench::getAllocationCount() - allocationsBefore)
+                       / static_cast<double>(tokensPerRound * lexerRounds));
+}
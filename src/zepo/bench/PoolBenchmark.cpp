@@ -0,0 +1,86 @@
+//
+// Created by qingy on 2024/8/8.
+//
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "Benchmark.hpp"
+#include "zepo/async/ThreadPool.hpp"
+#include "zepo/async/WorkStealingPool.hpp"
+
+namespace {
+    constexpr int jobsPerProducer = 100000;
+
+    // `producers` threads flood the pool with tiny jobs, wait until every job ran
+    template<typename PoolType>
+    void runContention(zepo::bench::BenchmarkContext& context, const int producers) {
+        const auto workerCount = static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u));
+        PoolType pool{workerCount, true};
+        std::atomic<int64_t> remaining{static_cast<int64_t>(producers) * jobsPerProducer};
+
+        context.measure(static_cast<uint64_t>(producers) * jobsPerProducer, [&] {
+            std::vector<std::thread> producerThreads{};
+            for (int i = 0; i < producers; ++i) {
+                producerThreads.emplace_back([&] {
+                    for (int j = 0; j < jobsPerProducer; ++j) {
+                        pool.put([&remaining] {
+                            if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                                remaining.notify_all();
+                            }
+                        });
+                    }
+                });
+            }
+
+            for (auto& thread: producerThreads) {
+                thread.join();
+            }
+
+            for (auto value = remaining.load(); value != 0; value = remaining.load()) {
+                remaining.wait(value);
+            }
+        });
+    }
+
+    // every job spawns the next ones from inside the pool, the work-stealing pool keeps them local
+    template<typename PoolType>
+    void runFanOut(zepo::bench::BenchmarkContext& context) {
+        constexpr int depth = 16;
+        const auto workerCount = static_cast<int>(std::max(std::thread::hardware_concurrency(), 1u));
+        PoolType pool{workerCount, true};
+        std::atomic<int64_t> remaining{(1 << depth) - 1};
+
+        std::function<void(int)> spawn = [&](const int level) {
+            pool.put([&, level] {
+                if (level + 1 < depth) {
+                    spawn(level + 1);
+                    spawn(level + 1);
+                }
+
+                if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    remaining.notify_all();
+                }
+            });
+        };
+
+        context.measure((1 << depth) - 1, [&] {
+            spawn(0);
+            for (auto value = remaining.load(); value != 0; value = remaining.load()) {
+                remaining.wait(value);
+            }
+        });
+    }
+}
+
+ZEPO_BENCHMARK_(pool_contention_1_producer_thread_pool) { runContention<zepo::ThreadPool>(context, 1); }
+ZEPO_BENCHMARK_(pool_contention_1_producer_work_stealing) { runContention<zepo::WorkStealingPool>(context, 1); }
+ZEPO_BENCHMARK_(pool_contention_4_producers_thread_pool) { runContention<zepo::ThreadPool>(context, 4); }
+ZEPO_BENCHMARK_(pool_contention_4_producers_work_stealing) { runContention<zepo::WorkStealingPool>(context, 4); }
+ZEPO_BENCHMARK_(pool_contention_16_producers_thread_pool) { runContention<zepo::ThreadPool>(context, 16); }
+ZEPO_BENCHMARK_(pool_contention_16_producers_work_stealing) { runContention<zepo::WorkStealingPool>(context, 16); }
+ZEPO_BENCHMARK_(pool_contention_64_producers_thread_pool) { runContention<zepo::ThreadPool>(context, 64); }
+ZEPO_BENCHMARK_(pool_contention_64_producers_work_stealing) { runContention<zepo::WorkStealingPool>(context, 64); }
+ZEPO_BENCHMARK_(pool_fan_out_thread_pool) { runFanOut<zepo::ThreadPool>(context); }
+ZEPO_BENCHMARK_(pool_fan_out_work_stealing) { runFanOut<zepo::WorkStealingPool>(context); }
@@ -0,0 +1,143 @@
+//
+// Created by qingy on 2024/8/14.
+//
+
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <vector>
+
+#include "Benchmark.hpp"
+#include "zepo/async/AsyncSemaphore.hpp"
+#include "zepo/async/Channel.hpp"
+#include "zepo/async/Executor.hpp"
+#include "zepo/async/RateLimiter.hpp"
+#include "zepo/async/Task.hpp"
+#include "zepo/async/TaskUtils.hpp"
+#include "zepo/async/WorkStealingPool.hpp"
+
+namespace {
+    constexpr int operationCount = 1000000;
+    constexpr int contendedOperations = 100000;
+    constexpr int channelItems = 200000;
+    constexpr int timerCount = 100000;
+
+    zepo::Task<> acquireRelease(zepo::AsyncSemaphore& semaphore, const int count) {
+        for (int i = 0; i < count; ++i) {
+            co_await semaphore.acquire();
+            semaphore.release();
+        }
+    }
+
+    // every worker hops to the CPU pool first, so they really run side by side
+    zepo::Task<> contendedWorker(zepo::AsyncSemaphore& semaphore, const int count) {
+        co_await zepo::scheduleOn(zepo::WorkStealingPool::getCpuPool());
+        co_await acquireRelease(semaphore, count);
+    }
+
+    zepo::Task<> produce(zepo::Channel<int>& channel, const int count) {
+        co_await zepo::scheduleOn(zepo::WorkStealingPool::getCpuPool());
+        for (int i = 0; i < count; ++i) {
+            co_await channel.send(i);
+        }
+    }
+
+    zepo::Task<> consume(zepo::Channel<int>& channel, std::atomic<int64_t>& sum) {
+        co_await zepo::scheduleOn(zepo::WorkStealingPool::getCpuPool());
+        int64_t localSum{0};
+        while (const auto value = co_await channel.receive()) {
+            localSum += *value;
+        }
+
+        sum.fetch_add(localSum, std::memory_order_relaxed);
+    }
+
+    void runSemaphoreContention(zepo::bench::BenchmarkContext& context, const int workers, const int64_t permits) {
+        zepo::AsyncSemaphore semaphore{permits};
+
+        context.measure(static_cast<uint64_t>(workers) * contendedOperations, [&] {
+            std::vector<zepo::Task<>> tasks{};
+            for (int i = 0; i < workers; ++i) {
+                tasks.push_back(contendedWorker(semaphore, contendedOperations));
+            }
+
+            zepo::TaskUtils::whenAll(tasks).wait();
+        });
+    }
+
+    void runPipeline(zepo::bench::BenchmarkContext& context, const int producers, const int consumers) {
+        zepo::Channel<int> channel{64};
+        std::atomic<int64_t> sum{0};
+
+        context.measure(channelItems, [&] {
+            std::vector<zepo::Task<>> producing{};
+            std::vector<zepo::Task<>> consuming{};
+            for (int i = 0; i < consumers; ++i) {
+                consuming.push_back(consume(channel, sum));
+            }
+            for (int i = 0; i < producers; ++i) {
+                producing.push_back(produce(channel, channelItems / producers));
+            }
+
+            auto consumed = zepo::TaskUtils::whenAll(consuming);
+            zepo::TaskUtils::whenAll(producing).wait();
+            channel.close();
+            consumed.wait();
+        });
+
+        zepo::bench::doNotOptimize(sum.load());
+    }
+}
+
+// fast path only, a permit is always available
+ZEPO_BENCHMARK_(semaphore_acquire_release_uncontended) {
+    zepo::AsyncSemaphore semaphore{1};
+    context.measure(operationCount, [&] {
+        acquireRelease(semaphore, operationCount).wait();
+    });
+}
+
+ZEPO_BENCHMARK_(semaphore_contended_4_workers_1_permit) { runSemaphoreContention(context, 4, 1); }
+
+ZEPO_BENCHMARK_(semaphore_contended_16_workers_4_permits) { runSemaphoreContention(context, 16, 4); }
+
+// a permit is always available, one compare-and-swap
+ZEPO_BENCHMARK_(rate_limiter_try_acquire) {
+    zepo::RateLimiter limiter{1e12, 1000};
+    context.measure(operationCount, [&] {
+        for (int i = 0; i < operationCount; ++i) {
+            zepo::bench::doNotOptimize(limiter.tryAcquire());
+        }
+    });
+}
+
+ZEPO_BENCHMARK_(channel_try_send_receive) {
+    zepo::Channel<int> channel{64};
+    int64_t sum{0};
+
+    context.measure(operationCount, [&] {
+        for (int i = 0; i < operationCount; ++i) {
+            (void) channel.trySend(i);
+            sum += *channel.tryReceive();
+        }
+    });
+
+    zepo::bench::doNotOptimize(sum);
+}
+
+ZEPO_BENCHMARK_(channel_pipeline_1_producer_1_consumer) { runPipeline(context, 1, 1); }
+
+ZEPO_BENCHMARK_(channel_pipeline_4_producers_4_consumers) { runPipeline(context, 4, 4); }
+
+// every timer lands within a few ticks, measures scheduling and firing rather than the wait
+ZEPO_BENCHMARK_(timer_delay_100k_concurrent) {
+    context.measure(timerCount, [&] {
+        std::vector<zepo::Task<>> delays{};
+        delays.reserve(timerCount);
+        for (int i = 0; i < timerCount; ++i) {
+            delays.push_back(zepo::TaskUtils::delay(std::chrono::milliseconds(i % 4)));
+        }
+
+        zepo::TaskUtils::whenAll(delays).wait();
+    });
+}
@@ -0,0 +1,143 @@
+//
+// Created by qingy on 2024/8/10.
+//
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "Benchmark.hpp"
+#include "zepo/async/Task.hpp"
+#include "zepo/async/TaskCompletionSource.hpp"
+#include "zepo/async/TaskUtils.hpp"
+#include "zepo/async/WorkStealingPool.hpp"
+
+namespace {
+    constexpr int taskCount = 1000000;
+    constexpr int chainDepth = 100000;
+    constexpr int roundTripCount = 20000;
+    constexpr int fanOutWidth = 10000;
+
+    zepo::Task<int> completeImmediately(const int value) {
+        co_return value;
+    }
+
+    zepo::Task<int64_t> awaitCompleted(const int count) {
+        int64_t sum{0};
+        for (int i = 0; i < count; ++i) {
+            sum += co_await completeImmediately(i);
+        }
+
+        co_return sum;
+    }
+
+    zepo::Task<int64_t> synchronousChain(const int depth) {
+        if (depth == 0) {
+            co_return 0;
+        }
+
+        co_return co_await synchronousChain(depth - 1) + 1;
+    }
+
+    zepo::Task<> awaitPending(zepo::Task<int> task, int64_t& sum) {
+        sum += co_await task;
+    }
+
+    // hop to the blocking pool and back, the cost every blocking call in the installer pays
+    zepo::Task<int64_t> runRoundTrips(const int count) {
+        int64_t sum{0};
+        for (int i = 0; i < count; ++i) {
+            sum += co_await zepo::TaskUtils::run<int>([i] { return i; });
+        }
+
+        co_return sum;
+    }
+
+    zepo::Task<int> completeOnCpuPool(const int value) {
+        co_await zepo::scheduleOn(zepo::WorkStealingPool::getCpuPool());
+        co_return value;
+    }
+}
+
+// coroutine frame + completion, observed synchronously
+ZEPO_BENCHMARK_(task_create_complete) {
+    context.measure(taskCount, [] {
+        for (int i = 0; i < taskCount; ++i) {
+            zepo::bench::doNotOptimize(completeImmediately(i).getValue());
+        }
+    });
+}
+
+// awaiting a task that already completed, never suspends
+ZEPO_BENCHMARK_(task_await_completed) {
+    context.measure(taskCount, [] {
+        zepo::bench::doNotOptimize(awaitCompleted(taskCount).getValue());
+    });
+}
+
+// suspend on a pending task, resumed by the completion
+ZEPO_BENCHMARK_(task_await_pending) {
+    constexpr int batchSize = 1000;
+    int64_t sum{0};
+
+    context.measure(taskCount, [&] {
+        for (int i = 0; i < taskCount; i += batchSize) {
+            std::vector<std::unique_ptr<zepo::TaskCompletionSource<int>>> sources{};
+            std::vector<zepo::Task<>> awaiting{};
+
+            for (int j = 0; j < batchSize; ++j) {
+                auto& source = sources.emplace_back(std::make_unique<zepo::TaskCompletionSource<int>>());
+                awaiting.push_back(awaitPending(source->getTask(), sum));
+                awaiting.back().start();
+            }
+
+            for (int j = 0; j < batchSize; ++j) {
+                sources[j]->setResult(j);
+            }
+        }
+    });
+
+    zepo::bench::doNotOptimize(sum);
+}
+
+// stress: every await completes synchronously, symmetric transfer keeps the native stack flat
+ZEPO_BENCHMARK_(task_sync_chain_100k) {
+    context.measure(chainDepth, [] {
+        if (synchronousChain(chainDepth).getValue() != chainDepth) {
+            throw std::runtime_error("synchronous chain lost a result");
+        }
+    });
+}
+
+// one TaskUtils::run from a coroutine: queue the job, run it, resume the awaiting coroutine
+ZEPO_BENCHMARK_(task_run_round_trip) {
+    context.measure(roundTripCount, [] {
+        zepo::bench::doNotOptimize(runRoundTrips(roundTripCount).getValue());
+    });
+}
+
+// whenAll over 10k tasks that complete synchronously, measures the bookkeeping alone
+ZEPO_BENCHMARK_(task_when_all_10k_completed) {
+    context.measure(fanOutWidth, [] {
+        std::vector<zepo::Task<int>> tasks{};
+        tasks.reserve(fanOutWidth);
+        for (int i = 0; i < fanOutWidth; ++i) {
+            tasks.push_back(completeImmediately(i));
+        }
+
+        zepo::bench::doNotOptimize(zepo::TaskUtils::whenAll(std::move(tasks)).getValue().size());
+    });
+}
+
+// whenAll over 10k tasks that each hop onto the CPU pool and complete there concurrently
+ZEPO_BENCHMARK_(task_when_all_10k_on_cpu_pool) {
+    context.measure(fanOutWidth, [] {
+        std::vector<zepo::Task<int>> tasks{};
+        tasks.reserve(fanOutWidth);
+        for (int i = 0; i < fanOutWidth; ++i) {
+            tasks.push_back(completeOnCpuPool(i));
+        }
+
+        zepo::bench::doNotOptimize(zepo::TaskUtils::whenAll(std::move(tasks)).getValue().size());
+    });
+}
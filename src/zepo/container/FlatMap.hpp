@@ -0,0 +1,171 @@
+//
+// Created by qingy on 2024/8/16.
+//
+
+#pragma once
+#ifndef ZEPO_FLATMAP_HPP
+#define ZEPO_FLATMAP_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace zepo {
+    // ordered map over one sorted vector: a single allocation, contiguous iteration and binary-search lookup.
+    // inserting in the middle is O(n), build it with `fromUnsorted` when the entries come in bulk.
+    // any insertion invalidates iterators and references
+    template<typename Key, typename Value, typename Compare = std::less<>>
+    class FlatMap {
+    public:
+        using key_type = Key;
+        using mapped_type = Value;
+        using value_type = std::pair<Key, Value>;
+        using iterator = typename std::vector<value_type>::iterator;
+        using const_iterator = typename std::vector<value_type>::const_iterator;
+
+    private:
+        std::vector<value_type> items_{};
+        [[no_unique_address]] Compare compare_{};
+
+        template<typename K>
+        iterator lowerBound(const K& key) {
+            return std::lower_bound(items_.begin(), items_.end(), key, [this](const value_type& item, const K& it) {
+                return compare_(item.first, it);
+            });
+        }
+
+        template<typename K>
+        const_iterator lowerBound(const K& key) const {
+            return std::lower_bound(items_.begin(), items_.end(), key, [this](const value_type& item, const K& it) {
+                return compare_(item.first, it);
+            });
+        }
+
+        template<typename K>
+        bool isKeyAt(const const_iterator iter, const K& key) const {
+            return iter != items_.end() && !compare_(key, iter->first);
+        }
+
+    public:
+        FlatMap() = default;
+
+        // sorts `items` once, the last of equal keys wins like repeated `operator[]` assignments
+        static FlatMap fromUnsorted(std::vector<value_type> items) {
+            FlatMap result{};
+            auto& compare = result.compare_;
+
+            // already strictly ascending, e.g. written out by another map, nothing to sort or drop
+            if (std::adjacent_find(items.begin(), items.end(), [&compare](const value_type& a, const value_type& b) {
+                return !compare(a.first, b.first);
+            }) == items.end()) {
+                result.items_ = std::move(items);
+                return result;
+            }
+
+            std::stable_sort(items.begin(), items.end(), [&compare](const value_type& a, const value_type& b) {
+                return compare(a.first, b.first);
+            });
+
+            auto output = items.begin();
+            for (auto iter = items.begin(); iter != items.end(); ++iter) {
+                if (output != items.begin() && !compare(std::prev(output)->first, iter->first)) {
+                    *std::prev(output) = std::move(*iter);
+                    continue;
+                }
+
+                if (output != iter) {
+                    *output = std::move(*iter);
+                }
+                ++output;
+            }
+
+            items.erase(output, items.end());
+            result.items_ = std::move(items);
+            return result;
+        }
+
+        template<typename K>
+        iterator find(const K& key) {
+            const auto iter = lowerBound(key);
+            return isKeyAt(iter, key) ? iter : items_.end();
+        }
+
+        template<typename K>
+        const_iterator find(const K& key) const {
+            const auto iter = lowerBound(key);
+            return isKeyAt(iter, key) ? iter : items_.end();
+        }
+
+        template<typename K>
+        [[nodiscard]] bool contains(const K& key) const {
+            return find(key) != items_.end();
+        }
+
+        template<typename K>
+        const Value& at(const K& key) const {
+            const auto iter = find(key);
+            if (iter == items_.end()) {
+                throw std::out_of_range("key not found");
+            }
+
+            return iter->second;
+        }
+
+        template<typename K, typename... Args>
+        std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) {
+            const auto iter = lowerBound(key);
+            if (isKeyAt(iter, key)) {
+                return {iter, false};
+            }
+
+            return {
+                items_.emplace(iter, std::piecewise_construct,
+                               std::forward_as_tuple(std::forward<K>(key)),
+                               std::forward_as_tuple(std::forward<Args>(args)...)),
+                true
+            };
+        }
+
+        template<typename K>
+        Value& operator[](K&& key) {
+            return try_emplace(std::forward<K>(key)).first->second;
+        }
+
+        void reserve(const size_t capacity) {
+            items_.reserve(capacity);
+        }
+
+        void clear() noexcept {
+            items_.clear();
+        }
+
+        [[nodiscard]] size_t size() const noexcept {
+            return items_.size();
+        }
+
+        [[nodiscard]] bool empty() const noexcept {
+            return items_.empty();
+        }
+
+        iterator begin() noexcept {
+            return items_.begin();
+        }
+
+        iterator end() noexcept {
+            return items_.end();
+        }
+
+        const_iterator begin() const noexcept {
+            return items_.begin();
+        }
+
+        const_iterator end() const noexcept {
+            return items_.end();
+        }
+    };
+}
+
+#endif //ZEPO_FLATMAP_HPP
@@ -0,0 +1,206 @@
+//
+// Created by qingy on 2024/8/16.
+//
+
+#pragma once
+#ifndef ZEPO_HASHMAP_HPP
+#define ZEPO_HASHMAP_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace zepo {
+    // hashes anything viewable as a string through `std::string_view`, so string keys are looked up without copies
+    struct TransparentHash {
+        template<typename K>
+        size_t operator()(const K& key) const {
+            if constexpr (std::is_convertible_v<const K&, std::string_view>) {
+                return std::hash<std::string_view>{}(key);
+            } else {
+                return std::hash<K>{}(key);
+            }
+        }
+    };
+
+    // open-addressing hash map: the entries live densely in insertion order, and a linear-probing table of
+    // 8-byte slots points into them. there is no erase, it is built for parsed documents and caches.
+    // any insertion invalidates iterators and references
+    template<typename Key, typename Value, typename Hash = TransparentHash, typename KeyEqual = std::equal_to<>>
+    class HashMap {
+    public:
+        using key_type = Key;
+        using mapped_type = Value;
+        using value_type = std::pair<Key, Value>;
+        using iterator = typename std::vector<value_type>::iterator;
+        using const_iterator = typename std::vector<value_type>::const_iterator;
+
+    private:
+        static constexpr size_t minSlotBits = 3;
+
+        struct Slot {
+            // entry index + 1, 0 is an empty slot
+            uint32_t index{0};
+            // low bits of the mixed hash, compared before the key
+            uint32_t tag{0};
+        };
+
+        std::vector<value_type> entries_{};
+        std::vector<Slot> slots_{};
+        size_t slotBits_{0};
+        [[no_unique_address]] Hash hash_{};
+        [[no_unique_address]] KeyEqual equal_{};
+
+        template<typename K>
+        uint64_t mix(const K& key) const {
+            // fibonacci hashing, the position comes from the high bits so weak hashes still spread
+            return static_cast<uint64_t>(hash_(key)) * 0x9e3779b97f4a7c15ull;
+        }
+
+        [[nodiscard]] size_t getPosition(const uint64_t mixed) const noexcept {
+            return static_cast<size_t>(mixed >> (64 - slotBits_));
+        }
+
+        // position of the slot holding `key`, or of the empty slot ending its probe sequence
+        template<typename K>
+        size_t probe(const K& key, const uint64_t mixed) const {
+            const auto mask = slots_.size() - 1;
+            const auto tag = static_cast<uint32_t>(mixed);
+            auto position = getPosition(mixed);
+            while (true) {
+                const auto& slot = slots_[position];
+                if (slot.index == 0) return position;
+                if (slot.tag == tag && equal_(entries_[slot.index - 1].first, key)) return position;
+
+                position = (position + 1) & mask;
+            }
+        }
+
+        void rehash(const size_t slotBits) {
+            slotBits_ = slotBits;
+            slots_.assign(size_t{1} << slotBits, Slot{});
+
+            const auto mask = slots_.size() - 1;
+            for (size_t index = 0; index < entries_.size(); ++index) {
+                const auto mixed = mix(entries_[index].first);
+                auto position = getPosition(mixed);
+                while (slots_[position].index != 0) {
+                    position = (position + 1) & mask;
+                }
+
+                slots_[position] = {static_cast<uint32_t>(index + 1), static_cast<uint32_t>(mixed)};
+            }
+        }
+
+        // keeps the load factor at or below 3/4
+        void growFor(const size_t count) {
+            if (count * 4 <= slots_.size() * 3) return;
+
+            auto slotBits = std::max(minSlotBits, slotBits_);
+            while (count * 4 > (size_t{1} << slotBits) * 3) {
+                slotBits++;
+            }
+
+            rehash(slotBits);
+        }
+
+    public:
+        HashMap() = default;
+
+        template<typename K>
+        iterator find(const K& key) {
+            if (entries_.empty()) return entries_.end();
+
+            const auto& slot = slots_[probe(key, mix(key))];
+            return slot.index == 0 ? entries_.end() : entries_.begin() + (slot.index - 1);
+        }
+
+        template<typename K>
+        const_iterator find(const K& key) const {
+            if (entries_.empty()) return entries_.end();
+
+            const auto& slot = slots_[probe(key, mix(key))];
+            return slot.index == 0 ? entries_.end() : entries_.begin() + (slot.index - 1);
+        }
+
+        template<typename K>
+        [[nodiscard]] bool contains(const K& key) const {
+            return find(key) != entries_.end();
+        }
+
+        template<typename K>
+        const Value& at(const K& key) const {
+            const auto iter = find(key);
+            if (iter == entries_.end()) {
+                throw std::out_of_range("key not found");
+            }
+
+            return iter->second;
+        }
+
+        template<typename K, typename... Args>
+        std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) {
+            growFor(entries_.size() + 1);
+
+            const auto mixed = mix(key);
+            auto& slot = slots_[probe(key, mixed)];
+            if (slot.index != 0) {
+                return {entries_.begin() + (slot.index - 1), false};
+            }
+
+            entries_.emplace_back(std::piecewise_construct,
+                                  std::forward_as_tuple(std::forward<K>(key)),
+                                  std::forward_as_tuple(std::forward<Args>(args)...));
+            slot = {static_cast<uint32_t>(entries_.size()), static_cast<uint32_t>(mixed)};
+            return {std::prev(entries_.end()), true};
+        }
+
+        template<typename K>
+        Value& operator[](K&& key) {
+            return try_emplace(std::forward<K>(key)).first->second;
+        }
+
+        void reserve(const size_t capacity) {
+            entries_.reserve(capacity);
+            growFor(capacity);
+        }
+
+        void clear() noexcept {
+            entries_.clear();
+            slots_.assign(slots_.size(), Slot{});
+        }
+
+        [[nodiscard]] size_t size() const noexcept {
+            return entries_.size();
+        }
+
+        [[nodiscard]] bool empty() const noexcept {
+            return entries_.empty();
+        }
+
+        // insertion order
+        iterator begin() noexcept {
+            return entries_.begin();
+        }
+
+        iterator end() noexcept {
+            return entries_.end();
+        }
+
+        const_iterator begin() const noexcept {
+            return entries_.begin();
+        }
+
+        const_iterator end() const noexcept {
+            return entries_.end();
+        }
+    };
+}
+
+#endif //ZEPO_HASHMAP_HPP
@@ -0,0 +1,78 @@
+//
+// Created by qingy on 2024/8/17.
+//
+
+#pragma once
+#ifndef ZEPO_STRINGPOOL_HPP
+#define ZEPO_STRINGPOOL_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace zepo {
+    // append-only storage for many small strings, copied into large blocks. the views it hands out stay
+    // valid until the pool is destroyed, moving the pool doesn't move the strings
+    class StringPool {
+        static constexpr size_t blockSize = 64 * 1024;
+
+        std::vector<std::unique_ptr<char[]>> blocks_{};
+        char* cursor_{nullptr};
+        size_t remaining_{0};
+        size_t size_{0};
+
+    public:
+        StringPool() = default;
+
+        StringPool(const StringPool&) = delete;
+
+        StringPool(StringPool&& other) noexcept
+            : blocks_{std::move(other.blocks_)},
+              cursor_{std::exchange(other.cursor_, nullptr)},
+              remaining_{std::exchange(other.remaining_, 0)},
+              size_{std::exchange(other.size_, 0)} {
+        }
+
+        StringPool& operator=(StringPool&& other) noexcept {
+            blocks_ = std::move(other.blocks_);
+            cursor_ = std::exchange(other.cursor_, nullptr);
+            remaining_ = std::exchange(other.remaining_, 0);
+            size_ = std::exchange(other.size_, 0);
+            return *this;
+        }
+
+        std::string_view store(const std::string_view value) {
+            if (value.empty()) return {};
+
+            size_ += value.size();
+
+            // large strings get a block of their own, the current block keeps its free space
+            if (value.size() > blockSize / 4) {
+                auto& block = blocks_.emplace_back(std::make_unique_for_overwrite<char[]>(value.size()));
+                std::memcpy(block.get(), value.data(), value.size());
+                return {block.get(), value.size()};
+            }
+
+            if (value.size() > remaining_) {
+                cursor_ = blocks_.emplace_back(std::make_unique_for_overwrite<char[]>(blockSize)).get();
+                remaining_ = blockSize;
+            }
+
+            const std::string_view result{cursor_, value.size()};
+            std::memcpy(cursor_, value.data(), value.size());
+            cursor_ += value.size();
+            remaining_ -= value.size();
+            return result;
+        }
+
+        // bytes of the strings stored so far
+        [[nodiscard]] size_t getSize() const noexcept {
+            return size_;
+        }
+    };
+}
+
+#endif //ZEPO_STRINGPOOL_HPP
@@ -0,0 +1,123 @@
+//
+// Created by qingy on 2024/8/3.
+//
+
+#include "Integrity.hpp"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <openssl/evp.h>
+
+namespace zepo::crypto {
+    struct EvpContextDeleter {
+        void operator()(EVP_MD_CTX* context) const {
+            EVP_MD_CTX_free(context);
+        }
+    };
+
+    Integrity Integrity::fromSubresource(std::string_view expression) {
+        // "sha512-xxx sha1-yyy", take the first hash only
+        if (const auto space = expression.find(' '); space != std::string_view::npos) {
+            expression = expression.substr(0, space);
+        }
+
+        const auto dash = expression.find('-');
+        if (dash == std::string_view::npos) {
+            throw std::runtime_error("invalid integrity expression: \"" + std::string{expression} + "\"");
+        }
+
+        const auto encoded = expression.substr(dash + 1);
+        Integrity result{};
+        result.algorithm_ = expression.substr(0, dash);
+        result.digest_.resize(encoded.size() / 4 * 3 + 3);
+
+        const auto decodedSize = EVP_DecodeBlock(result.digest_.data(),
+                                                 reinterpret_cast<const unsigned char*>(encoded.data()),
+                                                 static_cast<int>(encoded.size()));
+        if (decodedSize < 0) {
+            throw std::runtime_error("invalid integrity expression: \"" + std::string{expression} + "\"");
+        }
+
+        // EVP_DecodeBlock keeps the zero bytes produced by the padding
+        auto padding = 0;
+        for (auto iter = encoded.rbegin(); iter != encoded.rend() && *iter == '='; ++iter) {
+            padding++;
+        }
+
+        result.digest_.resize(decodedSize - padding);
+        return result;
+    }
+
+    static int parseHexDigit(const char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    Integrity Integrity::fromShasum(const std::string_view hex) {
+        if (hex.size() % 2 != 0) {
+            throw std::runtime_error("invalid shasum: \"" + std::string{hex} + "\"");
+        }
+
+        Integrity result{};
+        result.algorithm_ = "sha1";
+        result.digest_.reserve(hex.size() / 2);
+
+        for (size_t i = 0; i < hex.size(); i += 2) {
+            const auto high = parseHexDigit(hex[i]);
+            const auto low = parseHexDigit(hex[i + 1]);
+            if (high < 0 || low < 0) {
+                throw std::runtime_error("invalid shasum: \"" + std::string{hex} + "\"");
+            }
+
+            result.digest_.push_back(static_cast<unsigned char>(high << 4 | low));
+        }
+
+        return result;
+    }
+
+    bool Integrity::empty() const {
+        return digest_.empty();
+    }
+
+    const std::string& Integrity::getAlgorithm() const {
+        return algorithm_;
+    }
+
+    bool Integrity::matches(const std::filesystem::path& path, uint64_t& bytesRead) const {
+        bytesRead = 0;
+
+        const auto* digestType = EVP_get_digestbyname(algorithm_.c_str());
+        if (!digestType) {
+            throw std::runtime_error("unsupported integrity algorithm: \"" + algorithm_ + "\"");
+        }
+
+        std::ifstream stream{path, std::ios::in | std::ios::binary};
+        if (!stream.good()) {
+            return false;
+        }
+
+        const std::unique_ptr<EVP_MD_CTX, EvpContextDeleter> context{EVP_MD_CTX_new()};
+        EVP_DigestInit_ex(context.get(), digestType, nullptr);
+
+        std::array<char, 1024 * 64> buffer{}; // 64k
+        while (stream) {
+            stream.read(buffer.data(), buffer.size());
+            const auto count = stream.gcount();
+            if (count <= 0) break;
+
+            EVP_DigestUpdate(context.get(), buffer.data(), count);
+            bytesRead += count;
+        }
+
+        std::array<unsigned char, EVP_MAX_MD_SIZE> result{};
+        unsigned int resultSize{0};
+        EVP_DigestFinal_ex(context.get(), result.data(), &resultSize);
+
+        return resultSize == digest_.size() && std::equal(digest_.begin(), digest_.end(), result.begin());
+    }
+}
@@ -0,0 +1,38 @@
+//
+// Created by qingy on 2024/8/3.
+//
+
+#pragma once
+#ifndef ZEPO_INTEGRITY_HPP
+#define ZEPO_INTEGRITY_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace zepo::crypto {
+    // digest of a tarball, built from npm's "dist.integrity" (sri, e.g. "sha512-<base64>")
+    // or the legacy "dist.shasum" (hex sha1)
+    class Integrity {
+        std::string algorithm_{};
+        std::vector<unsigned char> digest_{};
+
+    public:
+        explicit Integrity() = default;
+
+        static Integrity fromSubresource(std::string_view expression);
+
+        static Integrity fromShasum(std::string_view hex);
+
+        [[nodiscard]] bool empty() const;
+
+        [[nodiscard]] const std::string& getAlgorithm() const;
+
+        // hash the whole file, `bytesRead` receives the amount of data consumed
+        [[nodiscard]] bool matches(const std::filesystem::path& path, uint64_t& bytesRead) const;
+    };
+}
+
+#endif //ZEPO_INTEGRITY_HPP
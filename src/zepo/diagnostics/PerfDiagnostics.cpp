@@ -18,6 +18,14 @@ namespace zepo {
         timeKinds_.try_emplace(std::string{kind}, timeLast);
     }
 
+    void PerfDiagnostics::pushPeak(std::string_view kind, long value) {
+        std::lock_guard lockGuard{mutex_};
+        if (const auto [result, inserted] = peakKinds_.try_emplace(std::string{kind}, value);
+            !inserted && result->second < value) {
+            result->second = value;
+        }
+    }
+
     void PerfDiagnostics::printTimes() const {
         std::cout << "== begin print times ==" << std::endl;
         for (const auto& [kind, time]: timeKinds_) {
@@ -27,6 +35,15 @@ namespace zepo {
         std::cout << "== finish print times ==" << std::endl;
     }
 
+    void PerfDiagnostics::printPeaks() const {
+        std::cout << "== begin print peaks ==" << std::endl;
+        for (const auto& [kind, value]: peakKinds_) {
+            std::cout << kind << ": " << value << "\n";
+        }
+
+        std::cout << "== finish print peaks ==" << std::endl;
+    }
+
     PerfDiagnostics& PerfDiagnostics::getDefault() {
         static PerfDiagnostics context{};
         return context;
@@ -15,6 +15,7 @@
 namespace zepo {
     class PerfDiagnostics {
         std::map<std::string, long, std::less<>> timeKinds_{};
+        std::map<std::string, long, std::less<>> peakKinds_{};
         std::mutex mutex_{};
 
     public:
@@ -22,8 +23,13 @@ namespace zepo {
 
         void pushTime(std::string_view kind, long timeLast);
 
+        // keeps the largest value pushed for `kind`, a high-water mark
+        void pushPeak(std::string_view kind, long value);
+
         void printTimes() const;
 
+        void printPeaks() const;
+
         static PerfDiagnostics& getDefault();
     };
 } // zepo
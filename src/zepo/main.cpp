@@ -3,33 +3,45 @@
 //
 
 #include <chrono>
+#include <csignal>
 #include <filesystem>
-#include <fstream>
 #include <iostream>
+#include <thread>
 #include <quickjs.h>
 
 #include "Manifest.hpp"
 #include "Configuration.hpp"
-#include "async/AsyncIO.hpp"
+#include "async/TaskUtils.hpp"
+#include "async/Executor.hpp"
+#include "async/WorkStealingPool.hpp"
 #include "async/Task.hpp"
 #include "serialize/Serializer.hpp"
 #include "serialize/Json.hpp"
+#include "serialize/JsonArena.hpp"
 #include "PackageInstallation.hpp"
+#include "StoreVerification.hpp"
 #include "async/Generator.hpp"
 #include "Global.hpp"
 #include "diagnostics/PerfDiagnostics.hpp"
 
 using namespace zepo;
 
+// cancelled by Ctrl-C, a second Ctrl-C terminates as usual
+static CancellationSource interruptCancellation{};
+
+static void handleInterrupt(int) {
+    interruptCancellation.cancel();
+    std::signal(SIGINT, SIG_DFL);
+}
+
 Task<Configuration> readConfiguration(const std::string_view rootPath) {
     std::filesystem::path configPath = rootPath;
     configPath = configPath.parent_path();
     configPath /= "config.json";
 
-    std::fstream configFile{configPath};
-
-    const auto configContent = co_await async_io::readString(configFile);
-    const JsonDocument jsonDoc{configContent};
+    const auto jsonDoc = co_await TaskUtils::run<JsonDocument>([&] {
+        return JsonDocument::fromFile(configPath);
+    });
     co_return parse<Configuration>(jsonDoc.getRootToken());
 }
 
@@ -39,8 +51,9 @@ Task<Package> readPackageManifest(bool openMutable = false) {
         throw std::runtime_error("File \"package.json\" not found");
     }
 
-    std::ifstream manifestFile{manifestPath};
-    const JsonDocument jsonDoc{co_await async_io::readString(manifestFile)};
+    const auto jsonDoc = co_await TaskUtils::run<JsonDocument>([&] {
+        return JsonDocument::fromFile(manifestPath);
+    });
     co_return parse<Package>(jsonDoc.getRootToken());
 }
 
@@ -48,18 +61,48 @@ Task<> performInstall() {
     const auto packageManifest = co_await readPackageManifest();
 
     ZEPO_PERF_BEGIN_(performInstall)
-    PackageInstallingContext context;
+    PackageInstallingContext context{interruptCancellation.getToken()};
+
+    try {
+        for (const auto& [packageName, source]: packageManifest.dependencies) {
+            co_await context.addRequirement(packageManifest.name, packageName, source);
+        }
+
+        for (const auto& [packageName, source]: packageManifest.devDependencies) {
+            co_await context.addRequirement(packageManifest.name, packageName, source);
+        }
 
-    for (const auto& [packageName, source]: packageManifest.dependencies) {
-        co_await context.addRequirement(packageManifest.name, packageName, source);
+        co_await context.resolveRequirements();
+    } catch (...) {
+        // don't let the work still in flight drain after a failure
+        context.cancel();
+        throw;
     }
+    ZEPO_PERF_END_(performInstall)
+}
+
+Task<> performStoreVerify(int argc, char** argv) {
+    bool shouldRepair{false};
+    int concurrency{static_cast<int>(std::thread::hardware_concurrency())};
 
-    for (const auto& [packageName, source]: packageManifest.devDependencies) {
-        co_await context.addRequirement(packageManifest.name, packageName, source);
+    for (int i = 0; i < argc; ++i) {
+        const std::string_view option{argv[i]};
+        if (option == "--repair") {
+            shouldRepair = true;
+        } else if (option == "--jobs" && i + 1 < argc) {
+            concurrency = std::atoi(argv[++i]);
+        } else {
+            throw std::runtime_error("Unknown option \"" + std::string{option} + "\"");
+        }
     }
 
-    co_await context.resolveRequirements();
-    ZEPO_PERF_END_(performInstall)
+    StoreVerifyingContext context{concurrency};
+    co_await context.verify();
+    context.printReport();
+
+    if (shouldRepair && context.getBrokenCount() > 0) {
+        co_await context.repair();
+    }
 }
 
 Task<> performGetPackage() {
@@ -70,6 +113,9 @@ void showHelp() {
 }
 
 Task<int> asyncMain(int argc, char** argv) {
+    // leave the main thread, it only waits for us
+    co_await scheduleOn(WorkStealingPool::getCpuPool());
+
     // skip first argument
     {
         argc--;
@@ -85,6 +131,8 @@ Task<int> asyncMain(int argc, char** argv) {
         } else if (command == "install") {
             co_await performInstall();
         } else if (command == "get-package") {
+        } else if (command == "store" && argc >= 2 && std::string_view{argv[1]} == "verify") {
+            co_await performStoreVerify(argc - 2, argv + 2);
         } else {
             shouldShowHelp = true;
         }
@@ -117,8 +165,14 @@ void initGlobals(int argc, char** argv) {
     JS_SetMemoryLimit(globalJsRuntime, 80 * 1024);
     JS_SetMaxStackSize(globalJsRuntime, 10 * 1024);
 
-    // load configuration
-    globalConfiguration = readConfiguration(argv[0]).getValue();
+    // load configuration, a bad value fails here rather than halfway through an install
+    try {
+        globalConfiguration = readConfiguration(argv[0]).getValue();
+        globalDurabilityMode = storage::parseDurabilityMode(globalConfiguration.durability);
+    } catch (const std::runtime_error& err) {
+        std::cerr << "Error: " << err.what() << std::endl;
+        std::exit(1);
+    }
 
     // load application paths
     path rootPath = argv[0];
@@ -136,10 +190,13 @@ void initGlobals(int argc, char** argv) {
 
 int main(int argc, char** argv) {
     initGlobals(argc, argv);
+    std::signal(SIGINT, handleInterrupt);
 
     auto mainTask = asyncMain(argc, argv);
     const auto result = mainTask.getValue();;
 
     PerfDiagnostics::getDefault().printTimes();
+    JsonArena::publishPeaks();
+    PerfDiagnostics::getDefault().printPeaks();
     return result;
 }
@@ -4,6 +4,7 @@
 
 #include "CurlAsyncIO.hpp"
 
+#include "CurlReactor.hpp"
 #include "zepo/diagnostics/PerfDiagnostics.hpp"
 
 namespace zepo::async_io {
@@ -12,11 +13,17 @@ namespace zepo::async_io {
         return size * count;
     }
 
-    Task<> curlExecuteAsync(const std::function<void(CURL*)>& configAction) {
+    static int curlCancellationProgress(void* token, curl_off_t, curl_off_t, curl_off_t, curl_off_t) {
+        return static_cast<const CancellationToken*>(token)->isCancellationRequested() ? 1 : 0;
+    }
+
+    Task<> curlExecuteAsync(const std::function<void(CURL*)>& configAction, CancellationToken cancellationToken) {
         CURL* instance = curl_easy_init();
         try {
+            // don't hand an error page to the writer as if it were the body
+            curl_easy_setopt(instance, CURLOPT_FAILONERROR, 1L);
             configAction(instance);
-            co_await curlEasyPerformAsync(instance);
+            co_await curlEasyPerformAsync(instance, std::move(cancellationToken));
             curl_easy_cleanup(instance);
         } catch (...) {
             const auto exception = std::current_exception();
@@ -25,24 +32,46 @@ namespace zepo::async_io {
         }
     }
 
-    Task<> async_io::curlEasyPerformAsync(CURL* curlInstance) {
-        co_await TaskUtils::run<void>([curlInstance] {
-            curl_easy_perform(curlInstance);
-        });
+    Task<> async_io::curlEasyPerformAsync(CURL* curlInstance, CancellationToken cancellationToken) {
+        cancellationToken.throwIfCancellationRequested();
+
+        if (cancellationToken.getState() != nullptr) {
+            curl_easy_setopt(curlInstance, CURLOPT_NOPROGRESS, 0L);
+            curl_easy_setopt(curlInstance, CURLOPT_XFERINFOFUNCTION, curlCancellationProgress);
+            curl_easy_setopt(curlInstance, CURLOPT_XFERINFODATA, &cancellationToken);
+        }
+
+        // the transfer runs on the reactor thread, we resume on the executor we came from
+        const auto result = co_await CurlReactor::getDefault().perform(curlInstance);
+        if (result == CURLE_ABORTED_BY_CALLBACK && cancellationToken.isCancellationRequested()) {
+            throw OperationCancelledException{};
+        }
+
+        if (result != CURLE_OK) {
+            throw CurlException(curl_easy_strerror(result));
+        }
+
+        // in case the caller turned CURLOPT_FAILONERROR off again
+        long responseCode{0};
+        curl_easy_getinfo(curlInstance, CURLINFO_RESPONSE_CODE, &responseCode);
+        if (responseCode >= 400) {
+            throw CurlException("HTTP status " + std::to_string(responseCode));
+        }
     }
 
-    Task<> curlEasyPerformAsync(const std::shared_ptr<CURL>& curlInstance) {
-        co_await curlEasyPerformAsync(curlInstance.get());
+    Task<> curlEasyPerformAsync(const std::shared_ptr<CURL>& curlInstance, CancellationToken cancellationToken) {
+        co_await curlEasyPerformAsync(curlInstance.get(), std::move(cancellationToken));
     }
 
-    Task<std::string> curlExecuteStringAsync(const std::function<void(CURL*)>& configAction) {
+    Task<std::string> curlExecuteStringAsync(const std::function<void(CURL*)>& configAction,
+                                             CancellationToken cancellationToken) {
         std::string result{};
 
         co_await curlExecuteAsync([&] (CURL* instance){
             curl_easy_setopt(instance, CURLOPT_WRITEFUNCTION, curlStringWriter);
             curl_easy_setopt(instance, CURLOPT_WRITEDATA, &result);
             configAction(instance);
-        });
+        }, std::move(cancellationToken));
 
         co_return result;
     }
@@ -7,18 +7,31 @@
 #define ZEPO_CURLASYNCIO_HPP
 
 #include <curl/curl.h>
+#include <stdexcept>
+#include <string>
+#include "zepo/async/CancellationToken.hpp"
 #include "zepo/async/Task.hpp"
 #include "zepo/async/TaskUtils.hpp"
 
 
 namespace zepo::async_io {
-    Task<> curlExecuteAsync(const std::function<void(CURL*)>& configAction);
+    // a transfer that failed, or got an HTTP error status back
+    class CurlException : public std::runtime_error {
+    public:
+        explicit CurlException(const std::string& message) : std::runtime_error("curl error: " + message) {
+        }
+    };
 
-    Task<> curlEasyPerformAsync(CURL* curlInstance);
+    // a cancelled token aborts the transfer from the progress callback and throws OperationCancelledException,
+    // any other failure and HTTP statuses from 400 on throw CurlException
+    Task<> curlExecuteAsync(const std::function<void(CURL*)>& configAction, CancellationToken cancellationToken = {});
 
-    Task<> curlEasyPerformAsync(const std::shared_ptr<CURL>& curlInstance);
+    Task<> curlEasyPerformAsync(CURL* curlInstance, CancellationToken cancellationToken = {});
 
-    Task<std::string> curlExecuteStringAsync(const std::function<void(CURL*)>& configAction);
+    Task<> curlEasyPerformAsync(const std::shared_ptr<CURL>& curlInstance, CancellationToken cancellationToken = {});
+
+    Task<std::string> curlExecuteStringAsync(const std::function<void(CURL*)>& configAction,
+                                             CancellationToken cancellationToken = {});
 }
 
 
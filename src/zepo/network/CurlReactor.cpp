@@ -0,0 +1,107 @@
+//
+// Created by qingy on 2024/8/13.
+//
+
+#include "CurlReactor.hpp"
+
+#include <ranges>
+#include <stdexcept>
+
+namespace zepo::async_io {
+    // bounds how late a cancelled transfer notices it, the progress callback only runs when curl is driven
+    constexpr int activePollTimeout = 50;
+    constexpr int idlePollTimeout = 60 * 1000;
+
+    CurlReactor::CurlReactor() : multi_{curl_multi_init()} {
+        if (multi_ == nullptr) {
+            throw std::runtime_error("failed to create the curl multi handle");
+        }
+
+        thread_ = std::thread{[this] { run(); }};
+    }
+
+    CurlReactor::~CurlReactor() {
+        running_.store(false, std::memory_order_release);
+        curl_multi_wakeup(multi_);
+        thread_.join();
+
+        // only reached at exit, nobody is left to resume
+        for (const auto& instance: transfers_ | std::views::keys) {
+            curl_multi_remove_handle(multi_, instance);
+        }
+
+        curl_multi_cleanup(multi_);
+    }
+
+    void CurlReactor::put(Action&& action) {
+        {
+            std::lock_guard lock{jobsLock_};
+            jobs_.push_back(std::move(action));
+        }
+
+        curl_multi_wakeup(multi_);
+    }
+
+    Task<CURLcode> CurlReactor::perform(CURL* instance) {
+        auto source = std::make_shared<TaskCompletionSource<CURLcode>>();
+        auto task = source->getTask();
+
+        put([this, instance, source = std::move(source)] {
+            if (const auto result = curl_multi_add_handle(multi_, instance); result != CURLM_OK) {
+                source->setException(std::make_exception_ptr(
+                    std::runtime_error{std::string{"curl error: "} + curl_multi_strerror(result)}));
+                return;
+            }
+
+            transfers_.emplace(instance, source);
+        });
+
+        return task;
+    }
+
+    void CurlReactor::completeTransfers() {
+        int remaining;
+        while (const auto* message = curl_multi_info_read(multi_, &remaining)) {
+            if (message->msg != CURLMSG_DONE) continue;
+
+            const auto node = transfers_.extract(message->easy_handle);
+            const auto result = message->data.result;
+            curl_multi_remove_handle(multi_, message->easy_handle);
+
+            // the awaiting coroutine is sent back to its own executor by the task
+            if (!node.empty()) {
+                node.mapped()->setResult(result);
+            }
+        }
+    }
+
+    void CurlReactor::run() {
+        setCurrent(this);
+
+        std::vector<Action> jobs{};
+        while (running_.load(std::memory_order_acquire)) {
+            {
+                std::lock_guard lock{jobsLock_};
+                jobs.swap(jobs_);
+            }
+
+            for (auto& job: jobs) {
+                job();
+            }
+            jobs.clear();
+
+            int runningCount;
+            curl_multi_perform(multi_, &runningCount);
+            completeTransfers();
+
+            curl_multi_poll(multi_, nullptr, 0, transfers_.empty() ? idlePollTimeout : activePollTimeout, nullptr);
+        }
+
+        setCurrent(nullptr);
+    }
+
+    CurlReactor& CurlReactor::getDefault() {
+        static CurlReactor defaultReactor{};
+        return defaultReactor;
+    }
+}
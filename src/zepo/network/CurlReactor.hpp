@@ -0,0 +1,53 @@
+//
+// Created by qingy on 2024/8/13.
+//
+
+#pragma once
+#ifndef ZEPO_CURLREACTOR_HPP
+#define ZEPO_CURLREACTOR_HPP
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <curl/curl.h>
+
+#include "zepo/async/Executor.hpp"
+#include "zepo/async/Task.hpp"
+#include "zepo/async/TaskCompletionSource.hpp"
+
+namespace zepo::async_io {
+    // the network thread, drives every transfer through one curl multi handle.
+    // jobs put on it run between two polls, keep them short
+    class CurlReactor final : public Executor {
+        CURLM* multi_;
+        std::thread thread_{};
+        std::atomic<bool> running_{true};
+
+        std::mutex jobsLock_{};
+        std::vector<Action> jobs_{};
+
+        // reactor thread only
+        std::map<CURL*, std::shared_ptr<TaskCompletionSource<CURLcode>>> transfers_{};
+
+        void run();
+
+        void completeTransfers();
+
+    public:
+        CurlReactor();
+
+        ~CurlReactor() override;
+
+        void put(Action&& action) override;
+
+        // completes with the result code on the reactor thread, `instance` must stay alive until then
+        Task<CURLcode> perform(CURL* instance);
+
+        static CurlReactor& getDefault();
+    };
+}
+
+#endif //ZEPO_CURLREACTOR_HPP
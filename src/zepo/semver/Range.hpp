@@ -128,13 +128,14 @@ namespace zepo::semver {
         using SharedNode = std::shared_ptr<BaseNode>;
 
     private:
-        static Generator<Token> lexer(std::string_view expression);
-
         static UniqueNode parser(Generator<Token>& tokenStream);
 
         SharedNode rootNode;
 
     public:
+        // each token is valid until the generator moves on
+        static Generator<Token> lexer(std::string_view expression);
+
         explicit Range(std::string_view expression);
 
         [[nodiscard]] bool satisfies(const Version& target) const;
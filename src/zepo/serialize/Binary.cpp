@@ -0,0 +1,144 @@
+//
+// Created by qingy on 2024/8/17.
+//
+
+#include "Binary.hpp"
+
+#include <cstring>
+#include <fstream>
+
+namespace zepo {
+    namespace {
+        constexpr std::string_view magic{"ZEPB"};
+        constexpr uint8_t formatVersion = 1;
+        constexpr size_t headerSize = 24;
+
+        void appendVarint(std::string& output, uint64_t value) {
+            while (value >= 0x80) {
+                output.push_back(static_cast<char>(value | 0x80));
+                value >>= 7;
+            }
+
+            output.push_back(static_cast<char>(value));
+        }
+
+        void appendFixed(std::string& output, const uint64_t value) {
+            for (size_t i = 0; i < sizeof(value); ++i) {
+                output.push_back(static_cast<char>(value >> (i * 8)));
+            }
+        }
+
+        uint64_t loadFixed(const char* data) {
+            uint64_t value{0};
+            for (size_t i = 0; i < sizeof(value); ++i) {
+                value |= static_cast<uint64_t>(static_cast<uint8_t>(data[i])) << (i * 8);
+            }
+
+            return value;
+        }
+
+        // advances `cursor`, throws instead of reading past `end`
+        uint64_t parseVarint(const char*& cursor, const char* end) {
+            uint64_t value{0};
+            for (size_t shift = 0; shift < 64; shift += 7) {
+                if (cursor == end) {
+                    throw BinaryFormatException("unexpected end of buffer");
+                }
+
+                const auto byte = static_cast<uint8_t>(*cursor++);
+                value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+                if (byte < 0x80) {
+                    return value;
+                }
+            }
+
+            throw BinaryFormatException("varint too long");
+        }
+    }
+
+    void BinaryWriter::writeVarint(const uint64_t value) {
+        appendVarint(body_, value);
+    }
+
+    void BinaryWriter::writeString(const std::string_view value) {
+        const auto [iter, inserted] = stringOffsets_.try_emplace(value, strings_.size());
+        if (inserted) {
+            appendVarint(strings_, value.size());
+            strings_.append(value);
+        }
+
+        appendVarint(body_, iter->second);
+    }
+
+    std::string BinaryWriter::finish(const uint64_t fingerprint) && {
+        std::string result{};
+        result.reserve(headerSize + strings_.size() + body_.size());
+
+        result.append(magic);
+        result.push_back(static_cast<char>(formatVersion));
+        result.append(3, '\0');
+        appendFixed(result, fingerprint);
+        appendFixed(result, strings_.size());
+        result.append(strings_);
+        result.append(body_);
+        return result;
+    }
+
+    BinaryReader::BinaryReader(const std::string_view buffer, const uint64_t fingerprint) {
+        if (buffer.size() < headerSize || buffer.substr(0, magic.size()) != magic) {
+            throw BinaryFormatException("not a binary buffer");
+        }
+
+        if (static_cast<uint8_t>(buffer[magic.size()]) != formatVersion) {
+            throw BinaryFormatException("unsupported format version");
+        }
+
+        if (loadFixed(buffer.data() + 8) != fingerprint) {
+            throw BinaryFormatException("schema mismatch");
+        }
+
+        const auto stringsSize = loadFixed(buffer.data() + 16);
+        if (stringsSize > buffer.size() - headerSize) {
+            throw BinaryFormatException("string table out of bounds");
+        }
+
+        strings_ = buffer.substr(headerSize, stringsSize);
+        cursor_ = strings_.data() + strings_.size();
+        end_ = buffer.data() + buffer.size();
+    }
+
+    uint64_t BinaryReader::readVarintSlow() {
+        return parseVarint(cursor_, end_);
+    }
+
+    std::string_view BinaryReader::readString() {
+        const auto offset = readVarint();
+        if (offset >= strings_.size()) {
+            throw BinaryFormatException("string offset out of bounds");
+        }
+
+        const auto* cursor = strings_.data() + offset;
+        const auto* end = strings_.data() + strings_.size();
+        const auto size = parseVarint(cursor, end);
+        if (size > static_cast<size_t>(end - cursor)) {
+            throw BinaryFormatException("string out of bounds");
+        }
+
+        return {cursor, static_cast<size_t>(size)};
+    }
+
+    void writeBinaryFile(const std::filesystem::path& path, const std::string_view content) {
+        auto temporaryPath = path;
+        temporaryPath += ".tmp";
+
+        {
+            std::ofstream stream{temporaryPath, std::ios::binary | std::ios::trunc};
+            stream.write(content.data(), static_cast<std::streamsize>(content.size()));
+            if (!stream) {
+                throw std::runtime_error("failed to write " + temporaryPath.string());
+            }
+        }
+
+        std::filesystem::rename(temporaryPath, path);
+    }
+}
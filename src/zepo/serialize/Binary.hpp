@@ -0,0 +1,515 @@
+//
+// Created by qingy on 2024/8/17.
+//
+
+#pragma once
+#ifndef ZEPO_BINARY_HPP
+#define ZEPO_BINARY_HPP
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "zepo/container/FlatMap.hpp"
+#include "zepo/container/HashMap.hpp"
+#include "zepo/serialize/Reflect.hpp"
+#include "zepo/storage/MappedFile.hpp"
+
+// compact cache format for reflected types. a buffer is
+//
+//   "ZEPB" | format version: u8 | 3 reserved bytes | schema fingerprint: u64 | string table size: u64
+//   | string table | body
+//
+// fixed width numbers are little endian. every distinct string is stored once in the table as a varint
+// length and its bytes, the body refers to it by its varint offset in the table. integers are varints,
+// zigzag encoded if signed, floats are their raw bits, containers are a varint count and their items,
+// and reflected structs are their fields in declaration order, without names.
+//
+// the fingerprint hashes the field names and types of the whole schema, so a buffer written by a build
+// with different structs is rejected instead of misread
+namespace zepo {
+    class BinaryFormatException : public std::runtime_error {
+    public:
+        explicit BinaryFormatException(const std::string& message)
+            : std::runtime_error("binary format error: " + message) {
+        }
+    };
+
+    namespace internal {
+        // fnv-1a, only for fingerprints
+        constexpr uint64_t hashBinaryName(const std::string_view name) noexcept {
+            uint64_t hash = 0xcbf29ce484222325ull;
+            for (const auto c: name) {
+                hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3ull;
+            }
+
+            return hash;
+        }
+
+        constexpr uint64_t mixFingerprint(const uint64_t hash, const uint64_t value) noexcept {
+            auto mixed = hash ^ (value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2));
+            mixed = (mixed ^ mixed >> 30) * 0xbf58476d1ce4e5b9ull;
+            mixed = (mixed ^ mixed >> 27) * 0x94d049bb133111ebull;
+            return mixed ^ mixed >> 31;
+        }
+    }
+
+    class BinaryWriter {
+        std::string strings_{};
+        std::string body_{};
+        // the strings only have to outlive the encoding
+        HashMap<std::string_view, uint64_t> stringOffsets_{};
+
+    public:
+        void writeVarint(uint64_t value);
+
+        void writeSigned(const int64_t value) {
+            writeVarint(static_cast<uint64_t>(value) << 1 ^ static_cast<uint64_t>(value >> 63));
+        }
+
+        template<std::unsigned_integral U>
+        void writeFixed(const U value) {
+            for (size_t i = 0; i < sizeof(U); ++i) {
+                body_.push_back(static_cast<char>(value >> (i * 8)));
+            }
+        }
+
+        void writeString(std::string_view value);
+
+        // the header, the string table and the body as one buffer
+        [[nodiscard]] std::string finish(uint64_t fingerprint) &&;
+    };
+
+    // reads straight out of the buffer, which has to outlive the reader and every string it returned
+    class BinaryReader {
+        std::string_view strings_{};
+        const char* cursor_{nullptr};
+        const char* end_{nullptr};
+
+        uint64_t readVarintSlow();
+
+    public:
+        // checks the header, throws `BinaryFormatException` if it isn't a buffer of this schema
+        BinaryReader(std::string_view buffer, uint64_t fingerprint);
+
+        uint64_t readVarint() {
+            // most counts, lengths and offsets are below 128
+            if (cursor_ != end_ && static_cast<uint8_t>(*cursor_) < 0x80) {
+                return static_cast<uint8_t>(*cursor_++);
+            }
+
+            return readVarintSlow();
+        }
+
+        int64_t readSigned() {
+            const auto value = readVarint();
+            return static_cast<int64_t>(value >> 1 ^ (~(value & 1) + 1));
+        }
+
+        template<std::unsigned_integral U>
+        U readFixed() {
+            if (getRemaining() < sizeof(U)) {
+                throw BinaryFormatException("unexpected end of buffer");
+            }
+
+            U value{0};
+            for (size_t i = 0; i < sizeof(U); ++i) {
+                value |= static_cast<U>(static_cast<uint8_t>(cursor_[i])) << (i * 8);
+            }
+
+            cursor_ += sizeof(U);
+            return value;
+        }
+
+        // a view into the string table
+        std::string_view readString();
+
+        [[nodiscard]] size_t getRemaining() const noexcept {
+            return static_cast<size_t>(end_ - cursor_);
+        }
+    };
+
+    // reflected structs, other types specialize it with the same three members
+    template<typename T>
+    struct BinaryTraits {
+    private:
+        struct EncodeHandler {
+            BinaryWriter& writer;
+            const T& value;
+
+            explicit EncodeHandler(BinaryWriter& writer, const T& value): writer{writer}, value{value} {
+            }
+
+            template<auto Name, auto FieldReference>
+            void field() {
+                using FieldType = std::remove_cvref_t<decltype(value.*FieldReference)>;
+                BinaryTraits<FieldType>::encode(writer, value.*FieldReference);
+            }
+
+            template<auto Attribute>
+            void attribute() {
+            }
+        };
+
+        struct DecodeHandler {
+            BinaryReader& reader;
+            T& result;
+
+            explicit DecodeHandler(BinaryReader& reader, T& result): reader{reader}, result{result} {
+            }
+
+            template<auto Name, auto FieldReference>
+            void field() {
+                using FieldType = std::remove_cvref_t<decltype(result.*FieldReference)>;
+                result.*FieldReference = BinaryTraits<FieldType>::decode(reader);
+            }
+
+            template<auto Attribute>
+            void attribute() {
+            }
+        };
+
+        // only runs in constant evaluation
+        struct FingerprintHandler {
+            uint64_t value{internal::hashBinaryName("struct")};
+
+            template<auto Name, auto FieldReference>
+            constexpr void field() {
+                using FieldType = typename internal::MemberPointerTraits<decltype(FieldReference)>::Type;
+                value = internal::mixFingerprint(value, internal::hashBinaryName(Name()));
+                value = internal::mixFingerprint(value, BinaryTraits<std::remove_cv_t<FieldType>>::fingerprint);
+            }
+
+            template<auto Attribute>
+            constexpr void attribute() {
+            }
+        };
+
+    public:
+        static constexpr uint64_t fingerprint = [] {
+            ReflectTraits<T, FingerprintHandler> handler{};
+            handler.execute();
+            return handler.value;
+        }();
+
+        static void encode(BinaryWriter& writer, const T& value) {
+            ReflectTraits<T, EncodeHandler> handler{writer, value};
+            handler.execute();
+        }
+
+        static T decode(BinaryReader& reader) {
+            T result{};
+            ReflectTraits<T, DecodeHandler> handler{reader, result};
+            handler.execute();
+            return result;
+        }
+    };
+
+    template<std::unsigned_integral T>
+    struct BinaryTraits<T> {
+        static constexpr uint64_t fingerprint =
+                internal::mixFingerprint(internal::hashBinaryName("unsigned"), sizeof(T));
+
+        static void encode(BinaryWriter& writer, const T value) {
+            writer.writeVarint(value);
+        }
+
+        static T decode(BinaryReader& reader) {
+            const auto value = reader.readVarint();
+            if (value > std::numeric_limits<T>::max()) {
+                throw BinaryFormatException("integer out of range");
+            }
+
+            return static_cast<T>(value);
+        }
+    };
+
+    template<std::signed_integral T>
+    struct BinaryTraits<T> {
+        static constexpr uint64_t fingerprint =
+                internal::mixFingerprint(internal::hashBinaryName("signed"), sizeof(T));
+
+        static void encode(BinaryWriter& writer, const T value) {
+            writer.writeSigned(value);
+        }
+
+        static T decode(BinaryReader& reader) {
+            const auto value = reader.readSigned();
+            if (value < std::numeric_limits<T>::min() || value > std::numeric_limits<T>::max()) {
+                throw BinaryFormatException("integer out of range");
+            }
+
+            return static_cast<T>(value);
+        }
+    };
+
+    template<>
+    struct BinaryTraits<float> {
+        static constexpr uint64_t fingerprint = internal::hashBinaryName("float");
+
+        static void encode(BinaryWriter& writer, const float value) {
+            writer.writeFixed(std::bit_cast<uint32_t>(value));
+        }
+
+        static float decode(BinaryReader& reader) {
+            return std::bit_cast<float>(reader.readFixed<uint32_t>());
+        }
+    };
+
+    template<>
+    struct BinaryTraits<double> {
+        static constexpr uint64_t fingerprint = internal::hashBinaryName("double");
+
+        static void encode(BinaryWriter& writer, const double value) {
+            writer.writeFixed(std::bit_cast<uint64_t>(value));
+        }
+
+        static double decode(BinaryReader& reader) {
+            return std::bit_cast<double>(reader.readFixed<uint64_t>());
+        }
+    };
+
+    template<>
+    struct BinaryTraits<std::string> {
+        static constexpr uint64_t fingerprint = internal::hashBinaryName("string");
+
+        static void encode(BinaryWriter& writer, const std::string& value) {
+            writer.writeString(value);
+        }
+
+        static std::string decode(BinaryReader& reader) {
+            return std::string{reader.readString()};
+        }
+    };
+
+    // same encoding as `std::string`, decoded without a copy
+    template<>
+    struct BinaryTraits<std::string_view> {
+        static constexpr uint64_t fingerprint = BinaryTraits<std::string>::fingerprint;
+
+        static void encode(BinaryWriter& writer, const std::string_view value) {
+            writer.writeString(value);
+        }
+
+        static std::string_view decode(BinaryReader& reader) {
+            return reader.readString();
+        }
+    };
+
+    template<typename T>
+    struct BinaryTraits<std::optional<T>> {
+        static constexpr uint64_t fingerprint =
+                internal::mixFingerprint(internal::hashBinaryName("optional"), BinaryTraits<T>::fingerprint);
+
+        static void encode(BinaryWriter& writer, const std::optional<T>& value) {
+            writer.writeVarint(value.has_value());
+            if (value.has_value()) {
+                BinaryTraits<T>::encode(writer, value.value());
+            }
+        }
+
+        static std::optional<T> decode(BinaryReader& reader) {
+            if (reader.readVarint() == 0) {
+                return std::nullopt;
+            }
+
+            return BinaryTraits<T>::decode(reader);
+        }
+    };
+
+    template<typename T>
+    struct BinaryTraits<std::vector<T>> {
+        static constexpr uint64_t fingerprint =
+                internal::mixFingerprint(internal::hashBinaryName("vector"), BinaryTraits<T>::fingerprint);
+
+        static void encode(BinaryWriter& writer, const std::vector<T>& value) {
+            writer.writeVarint(value.size());
+            for (const auto& item: value) {
+                BinaryTraits<T>::encode(writer, item);
+            }
+        }
+
+        static std::vector<T> decode(BinaryReader& reader) {
+            const auto count = reader.readVarint();
+
+            std::vector<T> result{};
+            // a corrupted count can't reserve more than the rest of the buffer
+            result.reserve(std::min<uint64_t>(count, reader.getRemaining()));
+            for (uint64_t i = 0; i < count; ++i) {
+                result.push_back(BinaryTraits<T>::decode(reader));
+            }
+
+            return result;
+        }
+    };
+
+    namespace internal {
+        // every map type shares the encoding, a cache can switch between them
+        template<typename Key, typename T>
+        constexpr uint64_t mapFingerprint = mixFingerprint(mixFingerprint(hashBinaryName("map"),
+                                                                          BinaryTraits<Key>::fingerprint),
+                                                           BinaryTraits<T>::fingerprint);
+
+        template<typename Key, typename T, typename Map>
+        void encodeMap(BinaryWriter& writer, const Map& value) {
+            writer.writeVarint(value.size());
+            for (const auto& [key, item]: value) {
+                BinaryTraits<Key>::encode(writer, key);
+                BinaryTraits<T>::encode(writer, item);
+            }
+        }
+
+        // calls `consumer(key, item)` for each pair after `reserve(count)`
+        template<typename Key, typename T, typename Reserve, typename Consumer>
+        void decodeMap(BinaryReader& reader, Reserve&& reserve, Consumer&& consumer) {
+            const auto count = reader.readVarint();
+            // a corrupted count can't reserve more than the rest of the buffer
+            reserve(static_cast<size_t>(std::min<uint64_t>(count, reader.getRemaining())));
+
+            for (uint64_t i = 0; i < count; ++i) {
+                // the key comes first in the buffer
+                auto key = BinaryTraits<Key>::decode(reader);
+                consumer(std::move(key), BinaryTraits<T>::decode(reader));
+            }
+        }
+    }
+
+    template<typename Key, typename T, typename Compare, typename Allocator>
+    struct BinaryTraits<std::map<Key, T, Compare, Allocator>> {
+        using Map = std::map<Key, T, Compare, Allocator>;
+
+        static constexpr uint64_t fingerprint = internal::mapFingerprint<Key, T>;
+
+        static void encode(BinaryWriter& writer, const Map& value) {
+            internal::encodeMap<Key, T>(writer, value);
+        }
+
+        static Map decode(BinaryReader& reader) {
+            Map result{};
+            internal::decodeMap<Key, T>(reader, [](size_t) {
+            }, [&result](Key key, T item) {
+                // written in order, so every pair goes to the end
+                result.emplace_hint(result.end(), std::move(key), std::move(item));
+            });
+
+            return result;
+        }
+    };
+
+    template<typename Key, typename T, typename Compare>
+    struct BinaryTraits<FlatMap<Key, T, Compare>> {
+        using Map = FlatMap<Key, T, Compare>;
+
+        static constexpr uint64_t fingerprint = internal::mapFingerprint<Key, T>;
+
+        static void encode(BinaryWriter& writer, const Map& value) {
+            internal::encodeMap<Key, T>(writer, value);
+        }
+
+        static Map decode(BinaryReader& reader) {
+            std::vector<typename Map::value_type> items{};
+            internal::decodeMap<Key, T>(reader, [&items](const size_t count) {
+                items.reserve(count);
+            }, [&items](Key key, T item) {
+                items.emplace_back(std::move(key), std::move(item));
+            });
+
+            // written sorted unless the buffer came from another map type
+            return Map::fromUnsorted(std::move(items));
+        }
+    };
+
+    template<typename Key, typename T, typename Hash, typename KeyEqual>
+    struct BinaryTraits<HashMap<Key, T, Hash, KeyEqual>> {
+        using Map = HashMap<Key, T, Hash, KeyEqual>;
+
+        static constexpr uint64_t fingerprint = internal::mapFingerprint<Key, T>;
+
+        static void encode(BinaryWriter& writer, const Map& value) {
+            internal::encodeMap<Key, T>(writer, value);
+        }
+
+        static Map decode(BinaryReader& reader) {
+            Map result{};
+            internal::decodeMap<Key, T>(reader, [&result](const size_t count) {
+                result.reserve(count);
+            }, [&result](Key key, T item) {
+                result[std::move(key)] = std::move(item);
+            });
+
+            return result;
+        }
+    };
+
+    template<typename T>
+    std::string encodeBinary(const T& value) {
+        BinaryWriter writer{};
+        BinaryTraits<T>::encode(writer, value);
+        return std::move(writer).finish(BinaryTraits<T>::fingerprint);
+    }
+
+    // string views in the result point into `buffer`
+    template<typename T>
+    T decodeBinary(const std::string_view buffer) {
+        BinaryReader reader{buffer, BinaryTraits<T>::fingerprint};
+        auto result = BinaryTraits<T>::decode(reader);
+        if (reader.getRemaining() != 0) {
+            throw BinaryFormatException("trailing bytes after the body");
+        }
+
+        return result;
+    }
+
+    // a decoded value together with the mapping its string views point into
+    template<typename T>
+    class BinaryBound {
+        storage::MappedFile file_;
+        T value_;
+
+    public:
+        BinaryBound(storage::MappedFile file, T value): file_{std::move(file)}, value_{std::move(value)} {
+        }
+
+        [[nodiscard]] const T& get() const {
+            return value_;
+        }
+
+        const T& operator*() const {
+            return value_;
+        }
+
+        const T* operator->() const {
+            return &value_;
+        }
+    };
+
+    // writes a temporary file next to `path` and renames it over, readers never see half a buffer
+    void writeBinaryFile(const std::filesystem::path& path, std::string_view content);
+
+    template<typename T>
+    void saveBinary(const std::filesystem::path& path, const T& value) {
+        writeBinaryFile(path, encodeBinary(value));
+    }
+
+    // maps the file and decodes it in place, throws `BinaryFormatException` for stale or damaged files
+    template<typename T>
+    BinaryBound<T> loadBinary(const std::filesystem::path& path) {
+        storage::MappedFile file{path};
+        auto value = decodeBinary<T>(file.getContent());
+        return {std::move(file), std::move(value)};
+    }
+}
+
+#endif //ZEPO_BINARY_HPP
@@ -4,6 +4,8 @@
 
 #include "Json.hpp"
 
+#include <cstdlib>
+#include <fstream>
 #include <sstream>
 #include <stdexcept>
 
@@ -81,6 +83,18 @@ namespace zepo {
         return mutable_ ? yyjson_mut_get_str(mutableVal_) : yyjson_get_str(val_);
     }
 
+    std::string_view JsonToken::toStringView() const {
+        const auto type = getObjectType();
+        if (type == YYJSON_TYPE_NONE || type == YYJSON_TYPE_NULL) {
+            return {};
+        }
+
+        checkObjectType(YYJSON_TYPE_STR);
+        return mutable_
+                   ? std::string_view{yyjson_mut_get_str(mutableVal_), yyjson_mut_get_len(mutableVal_)}
+                   : std::string_view{yyjson_get_str(val_), yyjson_get_len(val_)};
+    }
+
     double_t JsonToken::toDouble() const {
         checkObjectType(YYJSON_TYPE_NUM);
         return mutable_ ? yyjson_mut_get_num(mutableVal_) : yyjson_get_num(val_);
@@ -127,6 +141,12 @@ namespace zepo {
         return JsonToken{jsonDoc.getRawMutableValue(), yyjson_mut_str(jsonDoc.getRawMutableValue(), value.c_str())};
     }
 
+    JsonToken JsonToken::from(JsonDocument& jsonDoc, const std::string_view value) {
+        return JsonToken{
+            jsonDoc.getRawMutableValue(), yyjson_mut_strncpy(jsonDoc.getRawMutableValue(), value.data(), value.size())
+        };
+    }
+
     JsonToken JsonToken::from(JsonDocument& jsonDoc, double_t value) {
         return JsonToken{jsonDoc.getRawMutableValue(), yyjson_mut_real(jsonDoc.getRawMutableValue(), value)};
     }
@@ -176,45 +196,40 @@ namespace zepo {
         return JsonToken{jsonDoc.getRawMutableValue(), yyjson_mut_null(jsonDoc.getRawMutableValue())};
     }
 
-    void JsonToken::forEach(const ForEachItemAction& action) const {
+    JsonArrayRange JsonToken::items() const {
         checkObjectType(YYJSON_TYPE_ARR);
 
-        if (mutable_) {
-            size_t index, max;
-            yyjson_mut_val* item;
-            yyjson_mut_arr_foreach(mutableVal_, index, max, item) {
-                if (action(JsonToken{mutableDoc_, item})) break;
-            }
+        return JsonArrayRange{mutable_ ? JsonArrayIterator{mutableDoc_, mutableVal_} : JsonArrayIterator{val_}};
+    }
 
-            return;
-        }
+    JsonObjectRange JsonToken::members() const {
+        checkObjectType(YYJSON_TYPE_OBJ);
 
-        size_t index, max;
-        yyjson_val* item;
-        yyjson_arr_foreach(val_, index, max, item) {
-            if (action(JsonToken{item})) break;
-        }
+        return JsonObjectRange{mutable_ ? JsonObjectIterator{mutableDoc_, mutableVal_} : JsonObjectIterator{val_}};
     }
 
-    void JsonToken::forEach(const ForEachKeyValueAction& action) const {
+    JsonToken JsonToken::get(const std::string_view key) const {
         checkObjectType(YYJSON_TYPE_OBJ);
 
         if (mutable_) {
-            yyjson_mut_obj_iter iter;
-            yyjson_mut_obj_iter_init(mutableVal_, &iter);
-            yyjson_mut_val* key;
-            while ((key = yyjson_mut_obj_iter_next(&iter))) {
-                if (action(yyjson_mut_get_str(key), JsonToken{mutableDoc_, yyjson_mut_obj_iter_get_val(key)})) break;
-            }
-
-            return;
+            return JsonToken{mutableDoc_, yyjson_mut_obj_getn(mutableVal_, key.data(), key.size())};
         }
 
-        yyjson_obj_iter iter;
-        yyjson_obj_iter_init(val_, &iter);
-        yyjson_val* key;
-        while ((key = yyjson_obj_iter_next(&iter))) {
-            if (action(yyjson_get_str(key), JsonToken{yyjson_obj_iter_get_val(key)})) break;
+        return JsonToken{yyjson_obj_getn(val_, key.data(), key.size())};
+    }
+
+    bool JsonToken::exists() const {
+        return getObjectType() != YYJSON_TYPE_NONE;
+    }
+
+    size_t JsonToken::size() const {
+        switch (getObjectType()) {
+            case YYJSON_TYPE_ARR:
+                return mutable_ ? yyjson_mut_arr_size(mutableVal_) : yyjson_arr_size(val_);
+            case YYJSON_TYPE_OBJ:
+                return mutable_ ? yyjson_mut_obj_size(mutableVal_) : yyjson_obj_size(val_);
+            default:
+                throw std::runtime_error{"Type not match"};
         }
     }
 
@@ -233,7 +248,9 @@ namespace zepo {
         }
 
         checkObjectType(YYJSON_TYPE_OBJ);
-        yyjson_mut_obj_add_val(mutableDoc_, mutableVal_, key.data(), token.getRawMutableValue());
+        // yyjson keeps the key pointer and expects it NUL terminated, a view into a pool is neither
+        yyjson_mut_obj_add(mutableVal_, yyjson_mut_strncpy(mutableDoc_, key.data(), key.size()),
+                           token.getRawMutableValue());
     }
 
     JsonToken JsonDocument::getRootToken() const {
@@ -244,11 +261,12 @@ namespace zepo {
         return JsonToken{yyjson_doc_get_root(doc_.get())};
     }
 
-    JsonDocument::JsonDocument(const std::string_view content, const bool openMutable): mutable_{openMutable} {
+    void JsonDocument::read(char* content, const size_t size, const yyjson_read_flag flags, const bool openMutable,
+                            const yyjson_alc* allocator) {
         yyjson_read_err error;
         doc_ = {
-            yyjson_read_opts(const_cast<char*>(content.data()), content.size(),
-                             YYJSON_READ_ALLOW_COMMENTS | YYJSON_READ_ALLOW_TRAILING_COMMAS, nullptr, &error),
+            yyjson_read_opts(content, size,
+                             flags | YYJSON_READ_ALLOW_COMMENTS | YYJSON_READ_ALLOW_TRAILING_COMMAS, allocator, &error),
             yyjsonDeleter
         };
 
@@ -259,12 +277,53 @@ namespace zepo {
         }
 
         if (openMutable) {
-            mutableDoc_ = {yyjson_doc_mut_copy(doc_.get(), nullptr), yyjsonDeleter};
+            mutableDoc_ = {yyjson_doc_mut_copy(doc_.get(), allocator), yyjsonDeleter};
+        }
+    }
+
+    JsonDocument::JsonDocument(const std::string_view content, const bool openMutable, const yyjson_alc* allocator)
+        : mutable_{openMutable} {
+        read(const_cast<char*>(content.data()), content.size(), 0, openMutable, allocator);
+    }
+
+    JsonDocument::JsonDocument(std::shared_ptr<std::string> paddedBuffer, const bool openMutable,
+                               const yyjson_alc* allocator)
+        : buffer_{std::move(paddedBuffer)}, mutable_{openMutable} {
+        read(buffer_->data(), buffer_->size() - YYJSON_PADDING_SIZE, YYJSON_READ_INSITU, openMutable, allocator);
+    }
+
+    JsonDocument::JsonDocument(std::string&& content, const bool openMutable, const yyjson_alc* allocator)
+        : JsonDocument{
+            [&content] {
+                // the string lives on the heap from here on, so its data never moves again
+                auto buffer = std::make_shared<std::string>(std::move(content));
+                buffer->append(YYJSON_PADDING_SIZE, '\0');
+                return buffer;
+            }(),
+            openMutable,
+            allocator
+        } {
+    }
+
+    JsonDocument JsonDocument::fromFile(const std::filesystem::path& path, const bool openMutable,
+                                        const yyjson_alc* allocator) {
+        std::ifstream stream{path, std::ios::in | std::ios::binary};
+        if (!stream.good()) {
+            throw std::runtime_error("failed to open " + path.string());
         }
+
+        const auto size = static_cast<size_t>(std::filesystem::file_size(path));
+        auto buffer = std::make_shared<std::string>(size + YYJSON_PADDING_SIZE, '\0');
+        stream.read(buffer->data(), static_cast<std::streamsize>(size));
+        if (static_cast<size_t>(stream.gcount()) != size) {
+            throw std::runtime_error("failed to read " + path.string());
+        }
+
+        return JsonDocument{std::move(buffer), openMutable, allocator};
     }
 
-    JsonDocument::JsonDocument()
-        : mutableDoc_{yyjson_mut_doc_new(nullptr), yyjsonDeleter}, mutable_{true} {
+    JsonDocument::JsonDocument(const yyjson_alc* allocator)
+        : mutableDoc_{yyjson_mut_doc_new(allocator), yyjsonDeleter}, mutable_{true} {
     }
 
     yyjson_mut_doc* JsonDocument::getRawMutableValue() const {
@@ -284,10 +343,15 @@ namespace zepo {
     }
 
     std::string JsonDocument::stringify() {
-        if (!mutable_) {
-            return std::string{yyjson_write(doc_.get(), 0, nullptr)};
+        char* content = mutable_
+                            ? yyjson_mut_write(mutableDoc_.get(), 0, nullptr)
+                            : yyjson_write(doc_.get(), 0, nullptr);
+        if (!content) {
+            throw std::runtime_error("write error");
         }
 
-        return std::string{yyjson_mut_write(mutableDoc_.get(), 0, nullptr)};
+        std::string result{content};
+        free(content);
+        return result;
     }
 }
@@ -4,18 +4,24 @@
 
 #ifndef ZEPO_JSON_HPP
 #define ZEPO_JSON_HPP
-#include <functional>
+#include <cstddef>
+#include <filesystem>
+#include <iterator>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include <yyjson.h>
 
+#include "zepo/serialize/JsonArena.hpp"
+
 namespace zepo {
     struct JsonDocument;
+    class JsonArrayRange;
+    class JsonObjectRange;
 
     struct JsonToken {
-        using ForEachItemAction = std::function<bool(JsonToken)>;
-        using ForEachKeyValueAction = std::function<bool(std::string_view, JsonToken)>;
-
     private:
         bool mutable_{false};
 
@@ -44,6 +50,9 @@ namespace zepo {
 
         [[nodiscard]] std::string toString() const;
 
+        // points into the document, valid only while the document is alive. null gives an empty view
+        [[nodiscard]] std::string_view toStringView() const;
+
         [[nodiscard]] double_t toDouble() const;
 
         [[nodiscard]] float_t toFloat() const;
@@ -64,8 +73,12 @@ namespace zepo {
 
         [[nodiscard]] uint64_t toUint64() const;
 
+        // the document refers to `value`, it has to outlive the document
         static JsonToken from(JsonDocument& jsonDoc, const std::string& value);
 
+        // the document keeps its own copy of `value`
+        static JsonToken from(JsonDocument& jsonDoc, std::string_view value);
+
         static JsonToken from(JsonDocument& jsonDoc, double_t value);
 
         static JsonToken from(JsonDocument& jsonDoc, float_t value);
@@ -90,27 +103,232 @@ namespace zepo {
 
         static JsonToken fromNull(JsonDocument& jsonDoc);
 
-        void forEach(const ForEachItemAction& action) const;
+        // the items of an array, until `action` returns true. a template so the loop inlines the action
+        template<typename Action> requires std::is_invocable_r_v<bool, Action&, JsonToken>
+        void forEach(Action&& action) const;
+
+        // the members of an object in document order, until `action` returns true
+        template<typename Action> requires std::is_invocable_r_v<bool, Action&, std::string_view, JsonToken>
+        void forEach(Action&& action) const;
+
+        [[nodiscard]] JsonArrayRange items() const;
+
+        [[nodiscard]] JsonObjectRange members() const;
 
-        void forEach(const ForEachKeyValueAction& action) const;
+        // the value of `key` in an object, a null token (`exists()` is false) if there's none
+        [[nodiscard]] JsonToken get(std::string_view key) const;
+
+        // false for the token of a missing key or a default constructed one
+        [[nodiscard]] bool exists() const;
+
+        // items of an array or members of an object
+        [[nodiscard]] size_t size() const;
 
         void appendChild(const JsonToken& token);
 
+        // `key` is copied into the document
         void appendChild(std::string_view key, const JsonToken& token);
     };
 
+    // one member of an object, the key points into the document
+    struct JsonMember {
+        std::string_view key;
+        JsonToken value;
+    };
+
+    // input iterators over the children of a token, they end at `std::default_sentinel`
+    class JsonArrayIterator {
+        yyjson_arr_iter iter_{};
+        yyjson_mut_arr_iter mutableIter_{};
+        yyjson_mut_doc* mutableDoc_{nullptr};
+        yyjson_val* current_{nullptr};
+        yyjson_mut_val* mutableCurrent_{nullptr};
+        bool mutable_{false};
+
+        void advance() {
+            if (mutable_) {
+                mutableCurrent_ = yyjson_mut_arr_iter_next(&mutableIter_);
+            } else {
+                current_ = yyjson_arr_iter_next(&iter_);
+            }
+        }
+
+    public:
+        using value_type = JsonToken;
+        using difference_type = std::ptrdiff_t;
+
+        JsonArrayIterator() = default;
+
+        explicit JsonArrayIterator(yyjson_val* array) {
+            yyjson_arr_iter_init(array, &iter_);
+            advance();
+        }
+
+        JsonArrayIterator(yyjson_mut_doc* mutableDoc, yyjson_mut_val* array)
+            : mutableDoc_{mutableDoc}, mutable_{true} {
+            yyjson_mut_arr_iter_init(array, &mutableIter_);
+            advance();
+        }
+
+        JsonToken operator*() const {
+            return mutable_ ? JsonToken{mutableDoc_, mutableCurrent_} : JsonToken{current_};
+        }
+
+        JsonArrayIterator& operator++() {
+            advance();
+            return *this;
+        }
+
+        void operator++(int) {
+            advance();
+        }
+
+        bool operator==(std::default_sentinel_t) const {
+            return mutable_ ? mutableCurrent_ == nullptr : current_ == nullptr;
+        }
+    };
+
+    class JsonObjectIterator {
+        yyjson_obj_iter iter_{};
+        yyjson_mut_obj_iter mutableIter_{};
+        yyjson_mut_doc* mutableDoc_{nullptr};
+        yyjson_val* currentKey_{nullptr};
+        yyjson_mut_val* mutableCurrentKey_{nullptr};
+        bool mutable_{false};
+
+        void advance() {
+            if (mutable_) {
+                mutableCurrentKey_ = yyjson_mut_obj_iter_next(&mutableIter_);
+            } else {
+                currentKey_ = yyjson_obj_iter_next(&iter_);
+            }
+        }
+
+    public:
+        using value_type = JsonMember;
+        using difference_type = std::ptrdiff_t;
+
+        JsonObjectIterator() = default;
+
+        explicit JsonObjectIterator(yyjson_val* object) {
+            yyjson_obj_iter_init(object, &iter_);
+            advance();
+        }
+
+        JsonObjectIterator(yyjson_mut_doc* mutableDoc, yyjson_mut_val* object)
+            : mutableDoc_{mutableDoc}, mutable_{true} {
+            yyjson_mut_obj_iter_init(object, &mutableIter_);
+            advance();
+        }
+
+        JsonMember operator*() const {
+            if (mutable_) {
+                return {
+                    {yyjson_mut_get_str(mutableCurrentKey_), yyjson_mut_get_len(mutableCurrentKey_)},
+                    JsonToken{mutableDoc_, yyjson_mut_obj_iter_get_val(mutableCurrentKey_)}
+                };
+            }
+
+            return {
+                {yyjson_get_str(currentKey_), yyjson_get_len(currentKey_)},
+                JsonToken{yyjson_obj_iter_get_val(currentKey_)}
+            };
+        }
+
+        JsonObjectIterator& operator++() {
+            advance();
+            return *this;
+        }
+
+        void operator++(int) {
+            advance();
+        }
+
+        bool operator==(std::default_sentinel_t) const {
+            return mutable_ ? mutableCurrentKey_ == nullptr : currentKey_ == nullptr;
+        }
+    };
+
+    class JsonArrayRange {
+        JsonArrayIterator begin_;
+
+    public:
+        explicit JsonArrayRange(const JsonArrayIterator begin): begin_{begin} {
+        }
+
+        [[nodiscard]] JsonArrayIterator begin() const {
+            return begin_;
+        }
+
+        [[nodiscard]] std::default_sentinel_t end() const {
+            return {};
+        }
+    };
+
+    class JsonObjectRange {
+        JsonObjectIterator begin_;
+
+    public:
+        explicit JsonObjectRange(const JsonObjectIterator begin): begin_{begin} {
+        }
+
+        [[nodiscard]] JsonObjectIterator begin() const {
+            return begin_;
+        }
+
+        [[nodiscard]] std::default_sentinel_t end() const {
+            return {};
+        }
+    };
+
+    template<typename Action> requires std::is_invocable_r_v<bool, Action&, JsonToken>
+    void JsonToken::forEach(Action&& action) const {
+        for (const auto item: items()) {
+            if (action(item)) break;
+        }
+    }
+
+    template<typename Action> requires std::is_invocable_r_v<bool, Action&, std::string_view, JsonToken>
+    void JsonToken::forEach(Action&& action) const {
+        for (const auto& [key, value]: members()) {
+            if (action(key, value)) break;
+        }
+    }
+
     struct JsonDocument {
     private:
         std::shared_ptr<yyjson_doc> doc_{};
         std::shared_ptr<yyjson_mut_doc> mutableDoc_{};
+        // the source of an in-situ document, its strings point into it
+        std::shared_ptr<std::string> buffer_{};
         bool mutable_{false};
 
+        void read(char* content, size_t size, yyjson_read_flag flags, bool openMutable, const yyjson_alc* allocator);
+
+        // `paddedBuffer` ends with YYJSON_PADDING_SIZE zero bytes that aren't part of the content
+        explicit JsonDocument(std::shared_ptr<std::string> paddedBuffer, bool openMutable,
+                              const yyjson_alc* allocator);
+
     public:
         [[nodiscard]] JsonToken getRootToken() const;
 
-        explicit JsonDocument(std::string_view content, bool openMutable = false);
+        // the document memory comes from `allocator`, the arena by default and malloc with nullptr.
+        // the allocator must outlive the document
+
+        // copies `content`, it can be released right after
+        explicit JsonDocument(std::string_view content, bool openMutable = false,
+                              const yyjson_alc* allocator = JsonArena::getAllocator());
+
+        // takes over `content` and parses it in place, without another copy
+        explicit JsonDocument(std::string&& content, bool openMutable = false,
+                              const yyjson_alc* allocator = JsonArena::getAllocator());
 
-        explicit JsonDocument();
+        // one pre-sized read of the file, parsed in place
+        static JsonDocument fromFile(const std::filesystem::path& path, bool openMutable = false,
+                                     const yyjson_alc* allocator = JsonArena::getAllocator());
+
+        // an empty mutable document
+        explicit JsonDocument(const yyjson_alc* allocator = JsonArena::getAllocator());
 
         [[nodiscard]] yyjson_mut_doc* getRawMutableValue() const;
 
@@ -120,6 +338,34 @@ namespace zepo {
 
         std::string stringify();
     };
+
+    // a value parsed out of a document, holding a reference to the document so the
+    // `std::string_view`s inside the value stay valid for as long as the value itself
+    template<typename T>
+    class JsonBound {
+        JsonDocument document_;
+        T value_;
+
+    public:
+        JsonBound(JsonDocument document, T value): document_{std::move(document)}, value_{std::move(value)} {
+        }
+
+        [[nodiscard]] const T& get() const {
+            return value_;
+        }
+
+        const T& operator*() const {
+            return value_;
+        }
+
+        const T* operator->() const {
+            return &value_;
+        }
+
+        [[nodiscard]] const JsonDocument& getDocument() const {
+            return document_;
+        }
+    };
 }
 
 #endif //ZEPO_JSON_HPP
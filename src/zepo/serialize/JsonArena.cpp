@@ -0,0 +1,205 @@
+//
+// Created by qingy on 2024/8/16.
+//
+
+#include "JsonArena.hpp"
+
+#include <atomic>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#include "zepo/diagnostics/PerfDiagnostics.hpp"
+
+namespace zepo {
+    namespace {
+        constexpr size_t minClassBits = 10; // 1k
+        constexpr size_t sizeClassCount = 16; // up to 32m
+        constexpr size_t maxCachedBlocks = 8; // per size class and thread
+        constexpr size_t maxCachedBytes = size_t{64} << 20; // per thread
+
+        // in front of every block, keeps the payload 16-byte aligned
+        struct alignas(16) BlockHeader {
+            size_t sizeClass;
+            size_t capacity;
+        };
+
+        struct FreeBlock {
+            FreeBlock* next;
+        };
+
+        std::atomic<uint64_t> allocatedCount{0};
+        std::atomic<uint64_t> recycledCount{0};
+        std::atomic<uint64_t> oversizedCount{0};
+        std::atomic<uint64_t> liveBytes{0};
+        std::atomic<uint64_t> peakLiveBytes{0};
+        std::atomic<uint64_t> footprintBytes{0};
+        std::atomic<uint64_t> peakFootprintBytes{0};
+
+        // on the allocation path, only the atomics. `JsonArena::publishPeaks` reports them
+        void raisePeak(std::atomic<uint64_t>& peak, const uint64_t value) {
+            auto current = peak.load(std::memory_order_relaxed);
+            while (current < value) {
+                if (peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+                    return;
+                }
+            }
+        }
+
+        void addLive(const uint64_t bytes) {
+            const auto live = liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+            raisePeak(peakLiveBytes, live);
+        }
+
+        void addFootprint(const uint64_t bytes) {
+            const auto footprint = footprintBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+            raisePeak(peakFootprintBytes, footprint);
+        }
+
+        struct BlockCache {
+            FreeBlock* freeLists[sizeClassCount]{};
+            size_t freeCounts[sizeClassCount]{};
+            size_t cachedBytes{0};
+
+            ~BlockCache();
+        };
+
+        enum class CacheState : uint8_t {
+            Uninitialized,
+            Alive,
+            Destroyed,
+        };
+
+        // trivially destructible, still readable after the cache itself is gone
+        thread_local CacheState cacheState{CacheState::Uninitialized};
+        thread_local BlockCache blockCache{};
+
+        BlockCache::~BlockCache() {
+            cacheState = CacheState::Destroyed;
+
+            for (size_t sizeClass = 0; sizeClass < sizeClassCount; ++sizeClass) {
+                auto& freeList = freeLists[sizeClass];
+                while (freeList) {
+                    footprintBytes.fetch_sub(sizeof(BlockHeader) + (size_t{1} << (sizeClass + minClassBits)),
+                                             std::memory_order_relaxed);
+                    std::free(reinterpret_cast<BlockHeader*>(std::exchange(freeList, freeList->next)) - 1);
+                }
+            }
+        }
+
+        BlockCache* getCache() {
+            if (cacheState == CacheState::Destroyed) {
+                return nullptr;
+            }
+
+            cacheState = CacheState::Alive;
+            return &blockCache;
+        }
+
+        size_t getSizeClass(const size_t size) {
+            if (size <= (size_t{1} << minClassBits)) return 0;
+
+            return std::bit_width(size - 1) - minClassBits;
+        }
+
+        void* allocate(void*, const size_t size) {
+            allocatedCount.fetch_add(1, std::memory_order_relaxed);
+
+            const auto sizeClass = getSizeClass(size);
+            if (sizeClass >= sizeClassCount) {
+                oversizedCount.fetch_add(1, std::memory_order_relaxed);
+
+                auto* header = static_cast<BlockHeader*>(std::malloc(sizeof(BlockHeader) + size));
+                if (!header) return nullptr;
+
+                *header = {sizeClassCount, size};
+                addFootprint(sizeof(BlockHeader) + size);
+                addLive(size);
+                return header + 1;
+            }
+
+            const auto capacity = size_t{1} << (sizeClass + minClassBits);
+            if (auto* cache = getCache(); cache && cache->freeLists[sizeClass]) {
+                recycledCount.fetch_add(1, std::memory_order_relaxed);
+                cache->freeCounts[sizeClass]--;
+                cache->cachedBytes -= capacity;
+                addLive(capacity);
+                return std::exchange(cache->freeLists[sizeClass], cache->freeLists[sizeClass]->next);
+            }
+
+            // round up, so the block can serve any request of the same class later
+            auto* header = static_cast<BlockHeader*>(std::malloc(sizeof(BlockHeader) + capacity));
+            if (!header) return nullptr;
+
+            *header = {sizeClass, capacity};
+            addFootprint(sizeof(BlockHeader) + capacity);
+            addLive(capacity);
+            return header + 1;
+        }
+
+        void deallocate(void*, void* ptr) {
+            if (!ptr) return;
+
+            auto* header = static_cast<BlockHeader*>(ptr) - 1;
+            liveBytes.fetch_sub(header->capacity, std::memory_order_relaxed);
+
+            auto* cache = getCache();
+            const auto sizeClass = header->sizeClass;
+            if (!cache || sizeClass >= sizeClassCount || cache->freeCounts[sizeClass] >= maxCachedBlocks
+                || cache->cachedBytes + header->capacity > maxCachedBytes) {
+                footprintBytes.fetch_sub(sizeof(BlockHeader) + header->capacity, std::memory_order_relaxed);
+                std::free(header);
+                return;
+            }
+
+            // blocks may be freed on another thread than they were allocated, they just join this thread's list
+            auto* block = static_cast<FreeBlock*>(ptr);
+            block->next = cache->freeLists[sizeClass];
+            cache->freeLists[sizeClass] = block;
+            cache->freeCounts[sizeClass]++;
+            cache->cachedBytes += header->capacity;
+        }
+
+        void* reallocate(void* ctx, void* ptr, const size_t oldSize, const size_t size) {
+            if (!ptr) return allocate(ctx, size);
+
+            // yyjson grows its pools through here, the rounded up block often has the room already
+            if (static_cast<BlockHeader*>(ptr)[-1].capacity >= size) {
+                return ptr;
+            }
+
+            auto* result = allocate(ctx, size);
+            if (!result) return nullptr;
+
+            std::memcpy(result, ptr, oldSize < size ? oldSize : size);
+            deallocate(ctx, ptr);
+            return result;
+        }
+
+        constexpr yyjson_alc arenaAllocator{allocate, reallocate, deallocate, nullptr};
+    }
+
+    const yyjson_alc* JsonArena::getAllocator() {
+        return &arenaAllocator;
+    }
+
+    JsonArena::Statistics JsonArena::getStatistics() {
+        return {
+            allocatedCount.load(std::memory_order_relaxed),
+            recycledCount.load(std::memory_order_relaxed),
+            oversizedCount.load(std::memory_order_relaxed),
+            liveBytes.load(std::memory_order_relaxed),
+            peakLiveBytes.load(std::memory_order_relaxed),
+            footprintBytes.load(std::memory_order_relaxed),
+            peakFootprintBytes.load(std::memory_order_relaxed),
+        };
+    }
+
+    void JsonArena::publishPeaks() {
+        const auto statistics = getStatistics();
+        PerfDiagnostics::getDefault().pushPeak("jsonArenaLiveBytes", static_cast<long>(statistics.peakLiveBytes));
+        PerfDiagnostics::getDefault().pushPeak("jsonArenaFootprintBytes",
+                                               static_cast<long>(statistics.peakFootprintBytes));
+    }
+}
@@ -0,0 +1,43 @@
+//
+// Created by qingy on 2024/8/16.
+//
+
+#pragma once
+#ifndef ZEPO_JSONARENA_HPP
+#define ZEPO_JSONARENA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <yyjson.h>
+
+namespace zepo {
+    // yyjson allocator recycling document buffers through thread-local free lists, one per power-of-two
+    // size class. documents of similar sizes parsed over and over end up reusing the same few blocks
+    class JsonArena {
+    public:
+        struct Statistics {
+            // blocks requested in total
+            uint64_t allocated{0};
+            // blocks served from a free list
+            uint64_t recycled{0};
+            // blocks too large for any size class
+            uint64_t oversized{0};
+            // bytes held by documents right now, and the most ever held at once
+            uint64_t liveBytes{0};
+            uint64_t peakLiveBytes{0};
+            // bytes taken from malloc and not returned yet, including the free lists, and their high-water mark
+            uint64_t footprintBytes{0};
+            uint64_t peakFootprintBytes{0};
+        };
+
+        // lives forever, pass it to yyjson wherever a document is created
+        static const yyjson_alc* getAllocator();
+
+        static Statistics getStatistics();
+
+        // hands the high-water marks to PerfDiagnostics, call it before printing the peaks
+        static void publishPeaks();
+    };
+}
+
+#endif //ZEPO_JSONARENA_HPP
@@ -0,0 +1,450 @@
+//
+// Created by qingy on 2024/8/17.
+//
+
+#include "JsonStream.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+namespace zepo {
+    namespace {
+        constexpr uint32_t replacementCharacter = 0xfffd;
+
+        bool isWhitespace(const char c) {
+            return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+        }
+
+        bool isDelimiter(const char c) {
+            return isWhitespace(c) || c == ',' || c == '}' || c == ']';
+        }
+
+        bool isDigit(const char c) {
+            return c >= '0' && c <= '9';
+        }
+
+        int getHexValue(const char c) {
+            if (isDigit(c)) return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        }
+
+        bool isValidNumber(const std::string_view value) {
+            size_t position = 0;
+            const auto digits = [&] {
+                const auto begin = position;
+                while (position < value.size() && isDigit(value[position])) position++;
+                return position - begin;
+            };
+
+            if (position < value.size() && value[position] == '-') position++;
+            if (position < value.size() && value[position] == '0') {
+                position++;
+            } else if (digits() == 0) {
+                return false;
+            }
+
+            if (position < value.size() && value[position] == '.') {
+                position++;
+                if (digits() == 0) return false;
+            }
+
+            if (position < value.size() && (value[position] == 'e' || value[position] == 'E')) {
+                position++;
+                if (position < value.size() && (value[position] == '+' || value[position] == '-')) position++;
+                if (digits() == 0) return false;
+            }
+
+            return position == value.size();
+        }
+
+        bool isValidLiteral(const std::string_view value) {
+            return value == "true" || value == "false" || value == "null" || isValidNumber(value);
+        }
+    }
+
+    JsonStreamParser::JsonStreamParser(JsonStreamHandler& handler): handler_{handler} {
+    }
+
+    void JsonStreamParser::fail(const std::string_view message, const size_t position) const {
+        throw std::runtime_error("json stream error: " + std::string{message} + ", pos: "
+                                 + std::to_string(offset_ + position));
+    }
+
+    void JsonStreamParser::finishValue() {
+        state_ = containers_.empty() ? State::Done : State::CommaOrEnd;
+    }
+
+    void JsonStreamParser::finishString(const std::string_view value) {
+        if (stringIsKey_) {
+            state_ = State::Colon;
+            skipNextValue_ = !handler_.onKey(value);
+        } else {
+            handler_.onString(value);
+            finishValue();
+        }
+
+        pending_.clear();
+    }
+
+    void JsonStreamParser::appendCodePoint(const uint32_t codePoint) {
+        if (codePoint < 0x80) {
+            pending_.push_back(static_cast<char>(codePoint));
+        } else if (codePoint < 0x800) {
+            pending_.push_back(static_cast<char>(0xc0 | codePoint >> 6));
+            pending_.push_back(static_cast<char>(0x80 | (codePoint & 0x3f)));
+        } else if (codePoint < 0x10000) {
+            pending_.push_back(static_cast<char>(0xe0 | codePoint >> 12));
+            pending_.push_back(static_cast<char>(0x80 | (codePoint >> 6 & 0x3f)));
+            pending_.push_back(static_cast<char>(0x80 | (codePoint & 0x3f)));
+        } else {
+            pending_.push_back(static_cast<char>(0xf0 | codePoint >> 18));
+            pending_.push_back(static_cast<char>(0x80 | (codePoint >> 12 & 0x3f)));
+            pending_.push_back(static_cast<char>(0x80 | (codePoint >> 6 & 0x3f)));
+            pending_.push_back(static_cast<char>(0x80 | (codePoint & 0x3f)));
+        }
+    }
+
+    size_t JsonStreamParser::beginValue(const std::string_view chunk, const size_t position) {
+        const auto c = chunk[position];
+        const auto afterComma = std::exchange(afterComma_, false);
+
+        if (skipNextValue_) {
+            skipNextValue_ = false;
+            skipDepth_ = 0;
+            skipString_ = false;
+            skipEscape_ = false;
+            skipLiteral_ = false;
+
+            if (c == '{' || c == '[') {
+                skipDepth_ = 1;
+            } else if (c == '"') {
+                skipString_ = true;
+            } else if (c == '-' || isDigit(c) || c == 't' || c == 'f' || c == 'n') {
+                skipLiteral_ = true;
+                state_ = State::Skip;
+                return position;
+            } else {
+                fail("expected a value", position);
+            }
+
+            state_ = State::Skip;
+            return position + 1;
+        }
+
+        switch (c) {
+            case '{':
+                containers_.push_back(true);
+                state_ = State::KeyOrEnd;
+                handler_.onObjectBegin();
+                return position + 1;
+            case '[':
+                containers_.push_back(false);
+                state_ = State::Value;
+                handler_.onArrayBegin();
+                return position + 1;
+            case ']':
+                // only an empty array, not a trailing comma
+                if (containers_.empty() || containers_.back() || afterComma) {
+                    fail("unexpected ']'", position);
+                }
+
+                containers_.pop_back();
+                handler_.onArrayEnd();
+                finishValue();
+                return position + 1;
+            case '"':
+                stringIsKey_ = false;
+                state_ = State::String;
+                return position + 1;
+            default:
+                if (c == '-' || isDigit(c) || c == 't' || c == 'f' || c == 'n') {
+                    state_ = State::Literal;
+                    return position;
+                }
+
+                fail("expected a value", position);
+        }
+    }
+
+    size_t JsonStreamParser::scanString(const std::string_view chunk, size_t position) {
+        // a lone high surrogate from the previous escape
+        if (highSurrogate_ != 0 && chunk[position] != '\\') {
+            highSurrogate_ = 0;
+            appendCodePoint(replacementCharacter);
+        }
+
+        const auto begin = position;
+        while (position < chunk.size()) {
+            const auto c = chunk[position];
+            if (c == '"') {
+                // the common case, the whole string is inside this chunk and has no escapes
+                if (pending_.empty()) {
+                    finishString(chunk.substr(begin, position - begin));
+                } else {
+                    pending_.append(chunk.substr(begin, position - begin));
+                    finishString(pending_);
+                }
+
+                return position + 1;
+            }
+
+            if (c == '\\') {
+                pending_.append(chunk.substr(begin, position - begin));
+                state_ = State::Escape;
+                return position + 1;
+            }
+
+            if (static_cast<unsigned char>(c) < 0x20) {
+                fail("control character in string", position);
+            }
+
+            position++;
+        }
+
+        pending_.append(chunk.substr(begin));
+        return position;
+    }
+
+    size_t JsonStreamParser::scanEscape(const std::string_view chunk, size_t position) {
+        if (state_ == State::Escape) {
+            const auto c = chunk[position++];
+            if (c == 'u') {
+                state_ = State::Unicode;
+                unicodeValue_ = 0;
+                unicodeDigits_ = 0;
+                return position;
+            }
+
+            if (highSurrogate_ != 0) {
+                highSurrogate_ = 0;
+                appendCodePoint(replacementCharacter);
+            }
+
+            switch (c) {
+                case '"': pending_.push_back('"'); break;
+                case '\\': pending_.push_back('\\'); break;
+                case '/': pending_.push_back('/'); break;
+                case 'b': pending_.push_back('\b'); break;
+                case 'f': pending_.push_back('\f'); break;
+                case 'n': pending_.push_back('\n'); break;
+                case 'r': pending_.push_back('\r'); break;
+                case 't': pending_.push_back('\t'); break;
+                default: fail("invalid escape", position - 1);
+            }
+
+            state_ = State::String;
+            return position;
+        }
+
+        while (unicodeDigits_ < 4 && position < chunk.size()) {
+            const auto value = getHexValue(chunk[position]);
+            if (value < 0) {
+                fail("invalid unicode escape", position);
+            }
+
+            unicodeValue_ = unicodeValue_ << 4 | static_cast<uint32_t>(value);
+            unicodeDigits_++;
+            position++;
+        }
+
+        if (unicodeDigits_ < 4) return position;
+
+        state_ = State::String;
+        if (unicodeValue_ >= 0xdc00 && unicodeValue_ <= 0xdfff) {
+            appendCodePoint(highSurrogate_ != 0
+                                ? 0x10000 + ((highSurrogate_ - 0xd800) << 10) + (unicodeValue_ - 0xdc00)
+                                : replacementCharacter);
+            highSurrogate_ = 0;
+            return position;
+        }
+
+        if (highSurrogate_ != 0) {
+            appendCodePoint(replacementCharacter);
+            highSurrogate_ = 0;
+        }
+
+        if (unicodeValue_ >= 0xd800 && unicodeValue_ <= 0xdbff) {
+            // wait for the low half
+            highSurrogate_ = unicodeValue_;
+        } else {
+            appendCodePoint(unicodeValue_);
+        }
+
+        return position;
+    }
+
+    size_t JsonStreamParser::scanLiteral(const std::string_view chunk, size_t position) {
+        const auto begin = position;
+        while (position < chunk.size() && !isDelimiter(chunk[position])) {
+            position++;
+        }
+
+        pending_.append(chunk.substr(begin, position - begin));
+        if (position == chunk.size()) return position;
+
+        if (!isValidLiteral(pending_)) {
+            fail("invalid literal", position);
+        }
+
+        handler_.onLiteral(pending_);
+        pending_.clear();
+        finishValue();
+
+        // the delimiter belongs to whatever comes next
+        return position;
+    }
+
+    size_t JsonStreamParser::scanSkip(const std::string_view chunk, size_t position) {
+        // only strings and brackets are tracked, the skipped value isn't validated
+        while (position < chunk.size()) {
+            const auto c = chunk[position];
+            if (skipString_) {
+                if (skipEscape_) {
+                    skipEscape_ = false;
+                } else if (c == '\\') {
+                    skipEscape_ = true;
+                } else if (c == '"') {
+                    skipString_ = false;
+                    if (skipDepth_ == 0) {
+                        finishValue();
+                        return position + 1;
+                    }
+                }
+
+                position++;
+                continue;
+            }
+
+            if (skipLiteral_) {
+                if (isDelimiter(c)) {
+                    skipLiteral_ = false;
+                    finishValue();
+                    return position;
+                }
+
+                position++;
+                continue;
+            }
+
+            if (c == '"') {
+                skipString_ = true;
+            } else if (c == '{' || c == '[') {
+                skipDepth_++;
+            } else if (c == '}' || c == ']') {
+                if (--skipDepth_ == 0) {
+                    finishValue();
+                    return position + 1;
+                }
+            }
+
+            position++;
+        }
+
+        return position;
+    }
+
+    void JsonStreamParser::feed(const std::string_view chunk) {
+        size_t position = 0;
+        while (position < chunk.size()) {
+            switch (state_) {
+                case State::String:
+                    position = scanString(chunk, position);
+                    continue;
+                case State::Escape:
+                case State::Unicode:
+                    position = scanEscape(chunk, position);
+                    continue;
+                case State::Literal:
+                    position = scanLiteral(chunk, position);
+                    continue;
+                case State::Skip:
+                    position = scanSkip(chunk, position);
+                    continue;
+                default:
+                    break;
+            }
+
+            const auto c = chunk[position];
+            if (isWhitespace(c)) {
+                position++;
+                continue;
+            }
+
+            switch (state_) {
+                case State::Value:
+                    position = beginValue(chunk, position);
+                    break;
+                case State::KeyOrEnd:
+                    if (c == '"') {
+                        afterComma_ = false;
+                        stringIsKey_ = true;
+                        state_ = State::String;
+                    } else if (c == '}' && !afterComma_) {
+                        // only an empty object, not a trailing comma
+                        containers_.pop_back();
+                        handler_.onObjectEnd();
+                        finishValue();
+                    } else {
+                        fail("expected a key", position);
+                    }
+
+                    position++;
+                    break;
+                case State::Colon:
+                    if (c != ':') {
+                        fail("expected ':'", position);
+                    }
+
+                    state_ = State::Value;
+                    position++;
+                    break;
+                case State::CommaOrEnd:
+                    if (c == ',') {
+                        afterComma_ = true;
+                        state_ = containers_.back() ? State::KeyOrEnd : State::Value;
+                    } else if (c == (containers_.back() ? '}' : ']')) {
+                        const auto isObject = containers_.back();
+                        containers_.pop_back();
+                        if (isObject) {
+                            handler_.onObjectEnd();
+                        } else {
+                            handler_.onArrayEnd();
+                        }
+                        finishValue();
+                    } else {
+                        fail("expected ',' or the end of the container", position);
+                    }
+
+                    position++;
+                    break;
+                default:
+                    fail("unexpected content after the document", position);
+            }
+        }
+
+        offset_ += chunk.size();
+    }
+
+    void JsonStreamParser::finish() {
+        // a literal at the root is only terminated by the end of input
+        if (state_ == State::Literal && containers_.empty()) {
+            if (!isValidLiteral(pending_)) {
+                fail("invalid literal", 0);
+            }
+
+            handler_.onLiteral(pending_);
+            pending_.clear();
+            finishValue();
+        }
+
+        if (state_ != State::Done) {
+            fail("unexpected end of document", 0);
+        }
+    }
+
+    bool JsonStreamParser::isDone() const noexcept {
+        return state_ == State::Done;
+    }
+}
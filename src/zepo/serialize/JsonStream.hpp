@@ -0,0 +1,108 @@
+//
+// Created by qingy on 2024/8/17.
+//
+
+#pragma once
+#ifndef ZEPO_JSONSTREAM_HPP
+#define ZEPO_JSONSTREAM_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace zepo {
+    // events of a streaming parse. the views are only valid during the call
+    class JsonStreamHandler {
+    public:
+        virtual ~JsonStreamHandler() = default;
+
+        virtual void onObjectBegin() = 0;
+
+        virtual void onObjectEnd() = 0;
+
+        virtual void onArrayBegin() = 0;
+
+        virtual void onArrayEnd() = 0;
+
+        // false skips the value of this key without decoding it or reporting anything inside
+        virtual bool onKey(std::string_view key) = 0;
+
+        virtual void onString(std::string_view value) = 0;
+
+        // numbers, true, false and null as written
+        virtual void onLiteral(std::string_view value) = 0;
+    };
+
+    // push parser, the document is fed in chunks of any size as they arrive and the handler sees
+    // its events right away. only the string or literal cut by a chunk boundary is buffered
+    class JsonStreamParser {
+        enum class State : uint8_t {
+            Value,
+            KeyOrEnd,
+            Colon,
+            CommaOrEnd,
+            String,
+            Escape,
+            Unicode,
+            Literal,
+            Skip,
+            Done,
+        };
+
+        JsonStreamHandler& handler_;
+        State state_{State::Value};
+        // true for an object, false for an array
+        std::vector<bool> containers_{};
+        uint64_t offset_{0};
+
+        // the string or literal carried over from the previous chunk
+        std::string pending_{};
+        bool stringIsKey_{false};
+        bool skipNextValue_{false};
+        // a ',' was the last token, the container can't end right here
+        bool afterComma_{false};
+
+        uint32_t unicodeValue_{0};
+        uint8_t unicodeDigits_{0};
+        uint32_t highSurrogate_{0};
+
+        // skipping a value: open containers, and whether inside a string or right after a backslash
+        size_t skipDepth_{0};
+        bool skipString_{false};
+        bool skipEscape_{false};
+        bool skipLiteral_{false};
+
+        [[noreturn]] void fail(std::string_view message, size_t position) const;
+
+        void finishValue();
+
+        void finishString(std::string_view value);
+
+        void appendCodePoint(uint32_t codePoint);
+
+        size_t beginValue(std::string_view chunk, size_t position);
+
+        size_t scanString(std::string_view chunk, size_t position);
+
+        size_t scanEscape(std::string_view chunk, size_t position);
+
+        size_t scanLiteral(std::string_view chunk, size_t position);
+
+        size_t scanSkip(std::string_view chunk, size_t position);
+
+    public:
+        explicit JsonStreamParser(JsonStreamHandler& handler);
+
+        // throws std::runtime_error on malformed input
+        void feed(std::string_view chunk);
+
+        // the input ended, throws std::runtime_error if the document is incomplete
+        void finish();
+
+        [[nodiscard]] bool isDone() const noexcept;
+    };
+}
+
+#endif //ZEPO_JSONSTREAM_HPP
@@ -6,166 +6,378 @@
 #ifndef ZEPO_REFLECT_HPP
 #define ZEPO_REFLECT_HPP
 
-#include <functional>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
 #include <stdexcept>
 #include <string>
-#include <typeindex>
+#include <string_view>
+#include <type_traits>
+#include <typeinfo>
 
 namespace zepo {
-    inline void checkTypeMatch(const std::type_index& fieldType, std::string_view fieldName,
-                               const std::type_index& requiredType) {
+    namespace internal {
+        // `Count` bytes from `offset` as a little endian word, a single load outside constant evaluation
+        template<size_t Count>
+        constexpr uint64_t loadNameWord(const std::string_view name, const size_t offset) noexcept {
+            uint64_t word{0};
+            if (!std::is_constant_evaluated() && std::endian::native == std::endian::little) {
+                std::memcpy(&word, name.data() + offset, Count);
+                return word;
+            }
+
+            for (size_t i = 0; i < Count; ++i) {
+                word |= static_cast<uint64_t>(static_cast<uint8_t>(name[offset + i])) << (i * 8);
+            }
+
+            return word;
+        }
+
+        // the length and the first and last bytes of a name, read with overlapping loads instead of a loop.
+        // they cover every byte of names up to 16 long, so comparing keys replaces comparing those names
+        struct FieldNameKey {
+            uint64_t head{0};
+            uint64_t tail{0};
+            size_t size{0};
+
+            constexpr bool operator==(const FieldNameKey&) const = default;
+        };
+
+        constexpr FieldNameKey makeFieldNameKey(const std::string_view name) noexcept {
+            const auto size = name.size();
+            if (size >= 8) {
+                return {loadNameWord<8>(name, 0), loadNameWord<8>(name, size - 8), size};
+            }
+
+            if (size >= 4) {
+                return {loadNameWord<4>(name, 0) | loadNameWord<4>(name, size - 4) << 32, 0, size};
+            }
+
+            if (size > 0) {
+                const auto bytes = loadNameWord<1>(name, 0) | loadNameWord<1>(name, size / 2) << 8
+                                   | loadNameWord<1>(name, size - 1) << 16;
+                return {bytes, 0, size};
+            }
+
+            return {};
+        }
+
+        // the seed picks the multiplier, so a collision-free one can be searched for at compile time
+        constexpr uint32_t hashFieldName(const FieldNameKey& key, const uint32_t seed) noexcept {
+            const auto mixed = (key.head ^ key.tail * 0x9e3779b97f4a7c15ull ^ key.size)
+                               * (0xff51afd7ed558ccdull + seed * 2);
+            return static_cast<uint32_t>(mixed >> 32);
+        }
+
+        constexpr uint32_t hashFieldName(const std::string_view name, const uint32_t seed) noexcept {
+            return hashFieldName(makeFieldNameKey(name), seed);
+        }
+
+        struct PerfectHashLayout {
+            size_t bucketCount;
+            uint32_t seed;
+        };
+
+        template<size_t Count>
+        constexpr bool isCollisionFree(const std::array<std::string_view, Count>& names, const size_t bucketCount,
+                                       const uint32_t seed) {
+            for (size_t i = 0; i < Count; ++i) {
+                for (size_t j = i + 1; j < Count; ++j) {
+                    if (((hashFieldName(names[i], seed) ^ hashFieldName(names[j], seed)) & (bucketCount - 1)) == 0) {
+                        return false;
+                    }
+                }
+            }
+
+            return true;
+        }
+
+        // the smallest power of two table, at least twice the names, and a seed that gives every name its own
+        // bucket, so a lookup is one hash and one compare. duplicated names fail the constant evaluation
+        template<size_t Count>
+        constexpr PerfectHashLayout findPerfectHash(const std::array<std::string_view, Count>& names) {
+            constexpr size_t maxBucketCount = 1 << 16;
+            constexpr uint32_t seedsPerSize = 1024;
+
+            for (auto bucketCount = std::bit_ceil(std::max<size_t>(Count * 2, 1)); bucketCount <= maxBucketCount;
+                 bucketCount *= 2) {
+                for (uint32_t seed = 0; seed < seedsPerSize; ++seed) {
+                    if (isCollisionFree(names, bucketCount, seed)) {
+                        return {bucketCount, seed};
+                    }
+                }
+            }
+
+            throw std::logic_error("no perfect hash for the field names");
+        }
+    }
+
+    namespace internal {
+        template<typename>
+        struct MemberPointerTraits;
+
+        template<typename Class, typename Member>
+        struct MemberPointerTraits<Member Class::*> {
+            using ClassType = Class;
+            using Type = Member;
+        };
+
+        template<typename T>
+        const std::type_info& getTypeInfo() noexcept {
+            return typeid(T);
+        }
+    }
+
+    // one function per type, so the id is a constant and comparing ids is comparing pointers. calling it gives
+    // the `std::type_info` for messages
+    using TypeId = const std::type_info& (*)() noexcept;
+
+    template<typename T>
+    inline constexpr TypeId typeIdOf = &internal::getTypeInfo<T>;
+
+    inline void checkTypeMatch(const TypeId fieldType, std::string_view fieldName, const TypeId requiredType) {
         if (requiredType != fieldType) {
             std::string exceptionMessage;
             exceptionMessage.append("Field type mismatch: \"");
-            exceptionMessage.append(fieldType.name());
+            exceptionMessage.append(fieldType().name());
             exceptionMessage.append(" ");
             exceptionMessage.append(fieldName);
             exceptionMessage.append("\" and \"");
-            exceptionMessage.append(requiredType.name());
+            exceptionMessage.append(requiredType().name());
             exceptionMessage.append("\"");
             throw std::runtime_error(exceptionMessage);
         }
     }
 
-    using ValueSetter = std::function<void(void* self, void* value)>;
-    using ValueGetter = std::function<void*(void* self)>;
-    using AttributeGetter = std::function<void*()>;
-
-    struct FieldInfo;
-    struct AttributeInfo;
+    using ValueSetter = void (*)(void* self, const void* value);
+    using ValueGetter = void* (*)(void* self);
+    using AttributeGetter = void* (*)();
 
     struct AttributeInfo {
-        std::type_index type{typeid(void)};
-        AttributeGetter getter;
+        TypeId type{nullptr};
+        AttributeGetter getter{nullptr};
     };
 
     struct FieldInfo {
-        std::string name;
-        std::type_index type{typeid(void)};
-        ValueSetter setter;
-        ValueGetter getter;
-        std::vector<AttributeInfo> attributes;
-
-        [[nodiscard]] void* findAttribute(std::type_index type) const {
-            const auto iter = std::ranges::find_if(attributes, [&type](const AttributeInfo& it) {
-                return it.type == type;
-            });
-
-            if (iter == attributes.end()) {
-                return nullptr;
+        std::string_view name{};
+        internal::FieldNameKey key{};
+        TypeId type{nullptr};
+        ValueSetter setter{nullptr};
+        ValueGetter getter{nullptr};
+        // the attributes declared right before the field
+        std::span<const AttributeInfo> attributes{};
+
+        [[nodiscard]] void* findAttribute(const TypeId type) const {
+            for (const auto& attribute: attributes) {
+                if (attribute.type == type) {
+                    return attribute.getter();
+                }
             }
 
-            return iter->getter();
+            return nullptr;
         }
 
         template<typename AttributeType>
         AttributeType& findAttribute() const {
-            return *static_cast<AttributeType*>(findAttribute(typeid(AttributeType)));
+            return *static_cast<AttributeType*>(findAttribute(typeIdOf<AttributeType>));
         }
     };
 
+    template<typename Type, typename Handler>
+    struct ReflectTraits : Handler {
+        using Handler::Handler;
+
+        void execute() {
+            throw std::runtime_error("Unknown type: " + std::string(typeid(Type).name()));
+        }
+    };
+
+    namespace internal {
+        template<auto FieldReference>
+        void setFieldValue(void* self, const void* value) {
+            using Traits = MemberPointerTraits<decltype(FieldReference)>;
+            static_cast<typename Traits::ClassType*>(self)->*FieldReference =
+                    *static_cast<const typename Traits::Type*>(value);
+        }
+
+        template<auto FieldReference>
+        void* getFieldAddress(void* self) {
+            using Traits = MemberPointerTraits<decltype(FieldReference)>;
+            return &(static_cast<typename Traits::ClassType*>(self)->*FieldReference);
+        }
+
+        template<auto Attribute>
+        void* getAttributeAddress() {
+            return Attribute();
+        }
+
+        // handler for ReflectTraits, only runs in constant evaluation. counts first with no capacity, then
+        // fills arrays of the exact size
+        template<size_t FieldCapacity, size_t AttributeCapacity>
+        struct MetadataCollector {
+            std::array<FieldInfo, FieldCapacity> fields{};
+            std::array<AttributeInfo, AttributeCapacity> attributes{};
+            // where the attributes of every field begin
+            std::array<size_t, FieldCapacity> attributeOffsets{};
+            size_t fieldCount{0};
+            size_t attributeCount{0};
+            size_t pendingOffset{0};
+
+            template<auto Name, auto FieldReference>
+            constexpr void field() {
+                using FieldType = typename MemberPointerTraits<decltype(FieldReference)>::Type;
+
+                if (fieldCount < FieldCapacity) {
+                    fields[fieldCount] = {
+                        Name(), makeFieldNameKey(Name()), typeIdOf<FieldType>,
+                        &setFieldValue<FieldReference>, &getFieldAddress<FieldReference>, {}
+                    };
+                    attributeOffsets[fieldCount] = pendingOffset;
+                }
+
+                fieldCount++;
+                pendingOffset = attributeCount;
+            }
+
+            template<auto Attribute>
+            constexpr void attribute() {
+                using AttributeType = std::remove_pointer_t<decltype(Attribute())>;
+
+                if (attributeCount < AttributeCapacity) {
+                    attributes[attributeCount] = {typeIdOf<AttributeType>, &getAttributeAddress<Attribute>};
+                }
+
+                attributeCount++;
+            }
+        };
+    }
+
+    // the fields of a reflected type in declaration order, built entirely at compile time, so there is
+    // nothing to initialize at startup and a lookup by name is one perfect hash probe
     template<typename Type>
     struct TypeMetadata {
         using TargetType = Type;
 
     private:
-        std::vector<FieldInfo> fields_{};
+        static constexpr auto counts = [] {
+            ReflectTraits<Type, internal::MetadataCollector<0, 0>> collector{};
+            collector.execute();
+            return std::array{collector.fieldCount, collector.attributeCount};
+        }();
+
+        using Collector = internal::MetadataCollector<counts[0], counts[1]>;
+
+        static constexpr Collector collected = [] {
+            ReflectTraits<Type, Collector> collector{};
+            collector.execute();
+            return static_cast<Collector>(collector);
+        }();
 
     public:
-        template<typename FieldReference>
-        FieldInfo& addField(std::string name, FieldReference reference) {
-            using FieldType = decltype(TargetType{}.*reference);
+        static constexpr size_t fieldCount = counts[0];
+
+        static constexpr auto attributes = collected.attributes;
+
+        static constexpr auto fields = [] {
+            auto result = collected.fields;
+            for (size_t i = 0; i < fieldCount; ++i) {
+                const auto end = i + 1 < fieldCount ? collected.attributeOffsets[i + 1] : collected.pendingOffset;
+                result[i].attributes = std::span{attributes}.subspan(collected.attributeOffsets[i],
+                                                                      end - collected.attributeOffsets[i]);
+            }
 
-            auto setter = [reference](void* self, void* value) {
-                *static_cast<TargetType*>(self).*reference = *const_cast<const FieldType*>(static_cast<FieldType*>(
-                    value));
-            };
+            return result;
+        }();
+
+    private:
+        static constexpr auto layout = [] {
+            std::array<std::string_view, fieldCount> names{};
+            for (size_t i = 0; i < fieldCount; ++i) {
+                names[i] = fields[i].name;
+            }
+
+            return internal::findPerfectHash(names);
+        }();
+
+        // index + 1 of the field in each bucket, 0 for empty ones
+        static constexpr auto buckets = [] {
+            std::array<uint32_t, layout.bucketCount> result{};
+            for (size_t i = 0; i < fieldCount; ++i) {
+                result[internal::hashFieldName(fields[i].key, layout.seed) & (layout.bucketCount - 1)] =
+                        static_cast<uint32_t>(i + 1);
+            }
 
-            auto getter = [reference](void* self) {
-                return static_cast<void*>(&(*static_cast<TargetType*>(self).*reference));
-            };
+            return result;
+        }();
 
-            auto field = FieldInfo{name, typeid(FieldType), setter, getter};
-            return fields_.emplace_back(field);
+    public:
+        // nullptr for names that aren't a field, usable in constant expressions too
+        static constexpr const FieldInfo* tryFindField(const std::string_view name) noexcept {
+            const auto nameKey = internal::makeFieldNameKey(name);
+            const auto index = buckets[internal::hashFieldName(nameKey, layout.seed) & (layout.bucketCount - 1)];
+            if (index == 0) return nullptr;
+
+            const auto& field = fields[index - 1];
+            if (field.key != nameKey) return nullptr;
+
+            // the key words cover names up to 16 bytes
+            if (name.size() > 16 && field.name != name) return nullptr;
+
+            return &field;
         }
 
-        const FieldInfo& findField(std::string_view name) {
-            auto fieldIter = std::find_if(fields_.begin(), fields_.end(),
-                                          [&name](const FieldInfo& it) { return it.name == name; });
+        // the position of `field` in `fields`
+        static constexpr size_t indexOf(const FieldInfo* field) noexcept {
+            return static_cast<size_t>(field - fields.data());
+        }
 
-            if (fieldIter == fields_.end()) {
+        static constexpr const FieldInfo& findField(const std::string_view name) {
+            const auto* field = tryFindField(name);
+            if (!field) {
                 throw std::runtime_error("Failed to find field \"" + std::string(name) + "\"");
             }
 
-            return *fieldIter;
+            return *field;
         }
 
         template<typename FieldType>
-        FieldType getField(Type& instance, std::string_view name) {
+        static FieldType getField(Type& instance, const std::string_view name) {
             const auto& fieldInfo = findField(name);
-            checkTypeMatch(fieldInfo.type, fieldInfo.name, typeid(FieldType));
+            checkTypeMatch(fieldInfo.type, fieldInfo.name, typeIdOf<FieldType>);
 
             return *static_cast<const FieldType*>(fieldInfo.getter(&instance));
         }
 
         template<typename FieldType>
-        void setField(Type& instance, std::string_view name, const FieldType& value) {
+        static void setField(Type& instance, const std::string_view name, const FieldType& value) {
             const auto& fieldInfo = findField(name);
-            checkTypeMatch(fieldInfo.type, fieldInfo.name, typeid(FieldType));
+            checkTypeMatch(fieldInfo.type, fieldInfo.name, typeIdOf<FieldType>);
 
-            fieldInfo.setter(&instance, const_cast<FieldType*>(&value));
+            fieldInfo.setter(&instance, &value);
         }
     };
 
     template<typename Type>
-    struct MetadataHandler {
-        TypeMetadata<Type> metadata{};
-        std::vector<AttributeInfo> pendingAttributes{};
-
-        template<auto Name, auto FieldReference>
-        void field() {
-            auto& fieldInfo = metadata.addField(Name(), FieldReference);
-            fieldInfo.attributes = std::move(pendingAttributes);
-            pendingAttributes = {};
-        }
-
-        template<auto Attribute>
-        void attribute() {
-            pendingAttributes.push_back(AttributeInfo{
-                typeid(decltype(*Attribute())),
-                Attribute
-            });
-        }
-    };
-
-    template<typename Type, typename Handler>
-    struct ReflectTraits : Handler {
-        using Handler::Handler;
-
-        void execute() {
-            throw std::runtime_error("Unknown type: " + std::string(typeid(Type).name()));
-        }
-    };
-
-    template<typename Type>
-    auto metadataOf = TypeMetadata<Type>{};
+    inline constexpr TypeMetadata<Type> metadataOf{};
 }
 
 
 #ifndef ZEPO_NO_MACROS
 
-#define ZEPO_REFLECT_METADATA_(TYPE_) template<> \
-zepo::TypeMetadata<TYPE_> zepo::metadataOf<TYPE_> = []() { \
-    static zepo::ReflectTraits<TYPE_, zepo::MetadataHandler<TYPE_>> metadataHandler{}; \
-    metadataHandler.execute(); \
-    return metadataHandler.metadata; \
-}();
+// the metadata is built at compile time on first use, this only makes sure it builds where the type is declared
+#define ZEPO_REFLECT_METADATA_(TYPE_) \
+static_assert(zepo::TypeMetadata<TYPE_>::fields.size() == zepo::TypeMetadata<TYPE_>::fieldCount)
 
+// `execute` is constexpr so handlers that only collect names and member pointers run at compile time
 #define ZEPO_REFLECT_INFO_BEGIN_(TYPE_) template<typename Handler> \
     struct zepo::ReflectTraits<TYPE_, Handler> : Handler { \
         using CurrentType = TYPE_; \
         using Handler::Handler; \
-        void execute() {
+        constexpr void execute() {
 
 #define ZEPO_REFLECT_ATTRIBUTE_(ATTRIBUTE_) this->template attribute<[] { \
     static auto currentAttribute{ATTRIBUTE_}; \
@@ -7,11 +7,19 @@
 #ifndef ZEPO_SERIALIZER_HPP
 #define ZEPO_SERIALIZER_HPP
 
+#include "zepo/container/FlatMap.hpp"
+#include "zepo/container/HashMap.hpp"
 #include "zepo/serialize/Reflect.hpp"
+#include <array>
+#include <cmath>
+#include <concepts>
 #include <string>
+#include <string_view>
 #include <cstdint>
-#include <functional>
 #include <map>
+#include <optional>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace zepo {
@@ -19,12 +27,11 @@ namespace zepo {
     template<typename T, typename TokenType>
     T parse(const TokenType& token);
 
-    template<typename TokenType>
-    void forEach(const TokenType& token, const std::function<bool(TokenType)>& handler);
+    template<typename TokenType, typename Action>
+    void forEach(const TokenType& token, Action&& action);
 
     template<typename TokenType>
-    void forEach(const TokenType& token,
-                 const std::function<bool(std::string_view, TokenType)>& handler);
+    size_t getSizeHint(const TokenType& token);
 
     // definitions
     template<typename T, typename TokenType>
@@ -49,7 +56,7 @@ namespace zepo {
 
             template<auto Name, auto FieldReference>
             void field() {
-                using FieldType = decltype(T{}.*FieldReference);
+                using FieldType = std::remove_cvref_t<decltype(value.*FieldReference)>;
                 auto resultToken = TokenifyTraits<FieldType, DocType, TokenType>::tokenify(doc, value.*FieldReference);
                 token.appendChild(Name(), resultToken);
             }
@@ -75,6 +82,14 @@ namespace zepo {
         }
     };
 
+    // zero-copy, the view points into the parsed document, see `JsonBound`
+    template<typename TokenType>
+    struct ParseTraits<std::string_view, TokenType> {
+        static std::string_view parse(const TokenType& token) {
+            return token.toStringView();
+        }
+    };
+
     template<typename TokenType>
     struct ParseTraits<float_t, TokenType> {
         static float_t parse(const TokenType& token) {
@@ -158,6 +173,7 @@ namespace zepo {
 
         static Vector parse(const TokenType& token) {
             Vector vectorResult{};
+            vectorResult.reserve(getSizeHint(token));
             forEach<TokenType>(token, [&vectorResult](const TokenType& childToken) {
                 vectorResult.push_back(ParseTraits<T, TokenType>::parse(childToken));
                 return false;
@@ -182,6 +198,58 @@ namespace zepo {
         }
     };
 
+    // keys point into the parsed document like `std::string_view` fields
+    template<typename T, typename TokenType>
+    struct ParseTraits<std::map<std::string_view, T>, TokenType> {
+        using Map = std::map<std::string_view, T>;
+
+        static Map parse(const TokenType& token) {
+            Map mapResult{};
+
+            forEach<TokenType>(token, [&](std::string_view key, const TokenType& childToken) {
+                mapResult[key] = ParseTraits<T, TokenType>::parse(childToken);
+                return false;
+            });
+
+            return mapResult;
+        }
+    };
+
+    // collected in document order and sorted once
+    template<typename Key, typename T, typename Compare, typename TokenType>
+    struct ParseTraits<FlatMap<Key, T, Compare>, TokenType> {
+        using Map = FlatMap<Key, T, Compare>;
+
+        static Map parse(const TokenType& token) {
+            std::vector<typename Map::value_type> items{};
+            items.reserve(getSizeHint(token));
+
+            forEach<TokenType>(token, [&](std::string_view key, const TokenType& childToken) {
+                items.emplace_back(Key{key}, ParseTraits<T, TokenType>::parse(childToken));
+                return false;
+            });
+
+            return Map::fromUnsorted(std::move(items));
+        }
+    };
+
+    template<typename Key, typename T, typename Hash, typename KeyEqual, typename TokenType>
+    struct ParseTraits<HashMap<Key, T, Hash, KeyEqual>, TokenType> {
+        using Map = HashMap<Key, T, Hash, KeyEqual>;
+
+        static Map parse(const TokenType& token) {
+            Map mapResult{};
+            mapResult.reserve(getSizeHint(token));
+
+            forEach<TokenType>(token, [&](std::string_view key, const TokenType& childToken) {
+                mapResult[Key{key}] = ParseTraits<T, TokenType>::parse(childToken);
+                return false;
+            });
+
+            return mapResult;
+        }
+    };
+
     template<typename T, typename TokenType>
     struct ParseTraits<std::optional<T>, TokenType> {
         using Optional = std::optional<T>;
@@ -200,6 +268,15 @@ namespace zepo {
         }
     };
 
+    template<typename DocType, typename TokenType>
+    struct TokenifyTraits<std::string_view, DocType, TokenType> {
+        using TargetType = std::string_view;
+
+        static TokenType tokenify(DocType& doc, const TargetType& value) {
+            return TokenType::from(doc, value);
+        }
+    };
+
     template<typename DocType, typename TokenType>
     struct TokenifyTraits<uint8_t, DocType, TokenType> {
         using TargetType = uint8_t;
@@ -341,6 +418,55 @@ namespace zepo {
         }
     };
 
+    template<typename DocType, typename TokenType, typename WrappedType>
+    struct TokenifyTraits<std::map<std::string_view, WrappedType>, DocType, TokenType> {
+        using TargetType = std::map<std::string_view, WrappedType>;
+
+        static TokenType tokenify(DocType& doc, const TargetType& value) {
+            TokenType token{doc, false};
+
+            for (const auto& [key, item] : value) {
+                const auto resultToken = TokenifyTraits<WrappedType, DocType, TokenType>::tokenify(doc, item);
+                token.appendChild(key, resultToken);
+            }
+
+            return token;
+        }
+    };
+
+    template<typename DocType, typename TokenType, typename Key, typename WrappedType, typename Compare>
+    struct TokenifyTraits<FlatMap<Key, WrappedType, Compare>, DocType, TokenType> {
+        using TargetType = FlatMap<Key, WrappedType, Compare>;
+
+        static TokenType tokenify(DocType& doc, const TargetType& value) {
+            TokenType token{doc, false};
+
+            for (const auto& [key, item] : value) {
+                const auto resultToken = TokenifyTraits<WrappedType, DocType, TokenType>::tokenify(doc, item);
+                token.appendChild(key, resultToken);
+            }
+
+            return token;
+        }
+    };
+
+    template<typename DocType, typename TokenType, typename Key, typename WrappedType, typename Hash,
+        typename KeyEqual>
+    struct TokenifyTraits<HashMap<Key, WrappedType, Hash, KeyEqual>, DocType, TokenType> {
+        using TargetType = HashMap<Key, WrappedType, Hash, KeyEqual>;
+
+        static TokenType tokenify(DocType& doc, const TargetType& value) {
+            TokenType token{doc, false};
+
+            for (const auto& [key, item] : value) {
+                const auto resultToken = TokenifyTraits<WrappedType, DocType, TokenType>::tokenify(doc, item);
+                token.appendChild(key, resultToken);
+            }
+
+            return token;
+        }
+    };
+
     template<typename TokenType, typename T, typename DocType>
     TokenType tokenify(DocType& doc, const T& token) {
         return TokenifyTraits<T, DocType, TokenType>::tokenify(doc, token);
@@ -351,52 +477,98 @@ namespace zepo {
         return ParseTraits<T, TokenType>::parse(token);
     }
 
-    template<typename TokenType>
-    void forEach(const TokenType& token, const std::function<bool(TokenType)>& handler) {
-        token.forEach(handler);
+    // the action goes to the token as is, tokens with templated `forEach` like `JsonToken` inline it,
+    // others take it as a `std::function`
+    template<typename TokenType, typename Action>
+    void forEach(const TokenType& token, Action&& action) {
+        token.forEach(std::forward<Action>(action));
     }
 
+    // the children of an array or object if the token knows them up front, otherwise 0
     template<typename TokenType>
-    void forEach(const TokenType& token,
-                 const std::function<bool(std::string_view, TokenType)>& handler) {
-        token.forEach(handler);
+    size_t getSizeHint(const TokenType& token) {
+        if constexpr (requires { token.size(); }) {
+            return token.size();
+        } else {
+            return 0;
+        }
     }
 
+    // a direct lookup for tokens that have one, a scan of the members otherwise
     template<typename TokenType>
     TokenType get(const TokenType& token, std::string_view findKey) {
-        TokenType result{};
-        forEach(token, [&result, &findKey](auto key, auto value) {
-            if (findKey == key) {
-                result = std::move(value);
-                return true;
-            }
+        if constexpr (requires { { token.get(findKey) } -> std::same_as<TokenType>; }) {
+            return token.get(findKey);
+        } else {
+            TokenType result{};
+            forEach(token, [&result, &findKey](std::string_view key, const TokenType& value) {
+                if (findKey == key) {
+                    result = value;
+                    return true;
+                }
 
-            return false;
-        });
-        return result;
+                return false;
+            });
+            return result;
+        }
     }
 
+    // from a JSON key to the setter of the reflected field, through the compile-time lookup of `TypeMetadata`
     template<typename Type, typename TokenType>
-    struct DeserializeHandler {
-        Type& target;
-        const TokenType& token;
-        std::string_view targetName;
+    struct FieldDispatcher {
+        using Setter = void (*)(Type& target, const TokenType& token);
 
-        DeserializeHandler(Type& target, const TokenType& token, std::string_view targetName)
-            : target{target}, token{token}, targetName{targetName} {
+    private:
+        template<auto FieldReference>
+        static void setField(Type& target, const TokenType& token) {
+            target.*FieldReference = zepo::parse<std::remove_cvref_t<decltype(target.*FieldReference)>>(token);
         }
 
-        template<auto Name, auto FieldReference>
-        void field() {
-            if (targetName == Name()) {
-                target.*FieldReference = zepo::parse<decltype(Type{}.*FieldReference)>(token);
+        // handler for ReflectTraits, only runs in constant evaluation
+        struct SetterCollector {
+            std::array<Setter, TypeMetadata<Type>::fieldCount> setters{};
+            size_t count{0};
+
+            template<auto Name, auto FieldReference>
+            constexpr void field() {
+                setters[count++] = &setField<FieldReference>;
             }
-        }
 
-        template<auto Attribute>
-        void attribute() {
+            template<auto Attribute>
+            constexpr void attribute() {
+            }
+        };
+
+        // in the order of `TypeMetadata<Type>::fields`
+        static constexpr auto setters = [] {
+            ReflectTraits<Type, SetterCollector> collector{};
+            collector.execute();
+            return collector.setters;
+        }();
+
+    public:
+        // nullptr for keys that aren't a field
+        static Setter find(const std::string_view key) noexcept {
+            const auto* field = TypeMetadata<Type>::tryFindField(key);
+            if (!field) return nullptr;
+
+            return setters[TypeMetadata<Type>::indexOf(field)];
         }
     };
+
+    template<typename Type, typename TokenType>
+    Type parseFields(const TokenType& token) {
+        Type result{};
+        forEach<TokenType>(token, [&result](const std::string_view key, const TokenType& value) {
+            if (const auto setter = FieldDispatcher<Type, TokenType>::find(key)) {
+                setter(result, value);
+            }
+
+            return false;
+        });
+
+        return result;
+    }
 }
 
 #ifndef ZEPO_NO_MACROS
@@ -404,13 +576,7 @@ namespace zepo {
 #define ZEPO_REFLECT_PARSABLE_(TYPE_) template<typename TokenType> \
 struct zepo::ParseTraits<TYPE_, TokenType> { \
     static TYPE_ parse(const TokenType& token) { \
-        TYPE_ result; \
-        zepo::forEach<TokenType>(token, [&result](std::string_view key, const TokenType& value) { \
-            zepo::ReflectTraits<TYPE_, DeserializeHandler<TYPE_, TokenType>> reflectHandle{result, value, key}; \
-            reflectHandle.execute(); \
-            return false; \
-        }); \
-        return result; \
+        return zepo::parseFields<TYPE_, TokenType>(token); \
     } \
 }
 
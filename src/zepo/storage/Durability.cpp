@@ -0,0 +1,109 @@
+//
+// Created by qingy on 2024/8/5.
+//
+
+#include "Durability.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace zepo::storage {
+    DurabilityMode parseDurabilityMode(const std::optional<std::string>& expression) {
+        if (!expression.has_value() || expression.value() == "package") {
+            return DurabilityMode::Package;
+        }
+
+        if (expression.value() == "none") {
+            return DurabilityMode::None;
+        }
+
+        if (expression.value() == "install") {
+            return DurabilityMode::Install;
+        }
+
+        throw std::runtime_error("unknown durability mode: \"" + expression.value() + "\"");
+    }
+
+#ifdef _WIN32
+    void syncEntry(const std::filesystem::path& path) {
+        // directory entries are covered by the NTFS journal
+        if (is_directory(path)) return;
+
+        const auto handle = CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                                        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (handle == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("failed to open " + path.string() + " for syncing");
+        }
+
+        const auto succeed = FlushFileBuffers(handle);
+        CloseHandle(handle);
+
+        if (!succeed) {
+            throw std::runtime_error("failed to sync " + path.string());
+        }
+    }
+#else
+    void syncEntry(const std::filesystem::path& path) {
+        const auto fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error("failed to open " + path.string() + " for syncing");
+        }
+
+        const auto result = fsync(fd);
+        close(fd);
+
+        if (result != 0) {
+            throw std::runtime_error("failed to sync " + path.string());
+        }
+    }
+#endif
+
+#ifdef __linux__
+    void syncTrees(const std::vector<std::filesystem::path>& directories) {
+        std::vector<dev_t> syncedDevices{};
+
+        for (const auto& directory: directories) {
+            struct stat status{};
+            if (stat(directory.c_str(), &status) != 0) {
+                throw std::runtime_error("failed to stat " + directory.string());
+            }
+
+            if (std::ranges::find(syncedDevices, status.st_dev) != syncedDevices.end()) continue;
+
+            const auto fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (fd < 0) {
+                throw std::runtime_error("failed to open " + directory.string() + " for syncing");
+            }
+
+            const auto result = syncfs(fd);
+            close(fd);
+
+            if (result != 0) {
+                throw std::runtime_error("failed to sync " + directory.string());
+            }
+
+            syncedDevices.push_back(status.st_dev);
+        }
+    }
+#else
+    void syncTrees(const std::vector<std::filesystem::path>& directories) {
+        for (const auto& directory: directories) {
+            for (const auto& entry: std::filesystem::recursive_directory_iterator{directory}) {
+                syncEntry(entry.path());
+            }
+
+            syncEntry(directory);
+        }
+    }
+#endif
+}
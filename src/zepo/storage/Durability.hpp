@@ -0,0 +1,39 @@
+//
+// Created by qingy on 2024/8/5.
+//
+
+#pragma once
+#ifndef ZEPO_DURABILITY_HPP
+#define ZEPO_DURABILITY_HPP
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace zepo::storage {
+    enum class DurabilityMode {
+        // never sync, for scratch machines
+        None,
+        // sync every staged package once, before it is renamed into the store
+        Package,
+        // sync once when the whole install has finished
+        Install,
+    };
+
+    DurabilityMode parseDurabilityMode(const std::optional<std::string>& expression);
+
+    // flush a single file or directory entry
+    void syncEntry(const std::filesystem::path& path);
+
+    // flush everything below the given directories, one syncfs per filesystem where available,
+    // otherwise the files are flushed one by one
+    void syncTrees(const std::vector<std::filesystem::path>& directories);
+
+    inline void syncTree(const std::filesystem::path& directory) {
+        syncTrees({directory});
+    }
+}
+
+#endif //ZEPO_DURABILITY_HPP
@@ -0,0 +1,121 @@
+//
+// Created by qingy on 2024/8/17.
+//
+
+#include "MappedFile.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace zepo::storage {
+#ifdef _WIN32
+    MappedFile::MappedFile(const std::filesystem::path& path) {
+        const auto file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                                      OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("failed to open " + path.string());
+        }
+
+        LARGE_INTEGER size{};
+        if (!GetFileSizeEx(file, &size)) {
+            CloseHandle(file);
+            throw std::runtime_error("failed to stat " + path.string());
+        }
+
+        // nothing to map, and a zero sized mapping is an error
+        if (size.QuadPart == 0) {
+            CloseHandle(file);
+            return;
+        }
+
+        const auto mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (!mapping) {
+            throw std::runtime_error("failed to map " + path.string());
+        }
+
+        // the view keeps the mapping alive on its own
+        const auto view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+        if (!view) {
+            throw std::runtime_error("failed to map " + path.string());
+        }
+
+        data_ = static_cast<const char*>(view);
+        size_ = static_cast<size_t>(size.QuadPart);
+    }
+
+    void MappedFile::unmap() noexcept {
+        if (data_) {
+            UnmapViewOfFile(data_);
+        }
+    }
+#else
+    MappedFile::MappedFile(const std::filesystem::path& path) {
+        const auto fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error("failed to open " + path.string());
+        }
+
+        struct stat status{};
+        if (fstat(fd, &status) != 0) {
+            close(fd);
+            throw std::runtime_error("failed to stat " + path.string());
+        }
+
+        // nothing to map, and a zero sized mapping is an error
+        if (status.st_size == 0) {
+            close(fd);
+            return;
+        }
+
+        const auto size = static_cast<size_t>(status.st_size);
+        auto* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (view == MAP_FAILED) {
+            throw std::runtime_error("failed to map " + path.string());
+        }
+
+        // the whole file is about to be decoded, start reading it in right away
+        madvise(view, size, MADV_WILLNEED);
+
+        data_ = static_cast<const char*>(view);
+        size_ = size;
+    }
+
+    void MappedFile::unmap() noexcept {
+        if (data_) {
+            munmap(const_cast<char*>(data_), size_);
+        }
+    }
+#endif
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept
+        : data_{std::exchange(other.data_, nullptr)}, size_{std::exchange(other.size_, 0)} {
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            unmap();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+        }
+
+        return *this;
+    }
+
+    MappedFile::~MappedFile() {
+        unmap();
+    }
+}
@@ -0,0 +1,42 @@
+//
+// Created by qingy on 2024/8/17.
+//
+
+#pragma once
+#ifndef ZEPO_MAPPEDFILE_HPP
+#define ZEPO_MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+
+namespace zepo::storage {
+    // a whole file mapped read-only. the content doesn't move with the object, views into it stay valid
+    // until the mapping is destroyed
+    class MappedFile {
+        const char* data_{nullptr};
+        size_t size_{0};
+
+        void unmap() noexcept;
+
+    public:
+        MappedFile() = default;
+
+        // throws std::runtime_error if the file can't be opened or mapped
+        explicit MappedFile(const std::filesystem::path& path);
+
+        MappedFile(const MappedFile&) = delete;
+
+        MappedFile(MappedFile&& other) noexcept;
+
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        ~MappedFile();
+
+        [[nodiscard]] std::string_view getContent() const noexcept {
+            return {data_, size_};
+        }
+    };
+}
+
+#endif //ZEPO_MAPPEDFILE_HPP